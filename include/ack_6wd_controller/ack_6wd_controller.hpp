@@ -21,27 +21,54 @@
 #ifndef ACK_6WD_CONTROLLER__ACK_6WD_CONTROLLER_HPP_
 #define ACK_6WD_CONTROLLER__ACK_6WD_CONTROLLER_HPP_
 
+#include <semaphore.h>
+
+#include <atomic>
 #include <chrono>
 #include <cmath>
 #include <memory>
 #include <queue>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "controller_interface/controller_interface.hpp"
+#include "ack_6wd_controller/capture_window.hpp"
+#include "ack_6wd_controller/change_filter.hpp"
+#include "ack_6wd_controller/command_mux.hpp"
+#include "ack_6wd_controller/command_predictor.hpp"
+#include "ack_6wd_controller/flight_recorder.hpp"
+#include "ack_6wd_controller/interface_registry.hpp"
+#include "ack_6wd_controller/joint_transform.hpp"
+#include "ack_6wd_controller/kinematics.hpp"
 #include "ack_6wd_controller/odometry.hpp"
+#include "ack_6wd_controller/path_tracker.hpp"
+#include "ack_6wd_controller/online_calibration.hpp"
+#include "ack_6wd_controller/seqlock.hpp"
+#include "ack_6wd_controller/shared_command.hpp"
+#include "ack_6wd_controller/slip_detector.hpp"
+#include "ack_6wd_controller/spsc_queue.hpp"
 #include "ack_6wd_controller/speed_limiter.hpp"
+#include "ack_6wd_controller/telemetry_log.hpp"
+#include "ack_6wd_controller/tick_accumulator.hpp"
+#include "ack_6wd_controller/thread_priority.hpp"
+#include "ack_6wd_controller/tracking_monitor.hpp"
+#include "ack_6wd_controller/triple_buffer.hpp"
 #include "ack_6wd_controller/visibility_control.h"
+#include "ack_6wd_controller/zone_map.hpp"
 #include "geometry_msgs/msg/twist.hpp"
 #include "geometry_msgs/msg/twist_stamped.hpp"
 #include "hardware_interface/handle.hpp"
 #include "nav_msgs/msg/odometry.hpp"
+#include "nav_msgs/msg/path.hpp"
 #include "odometry.hpp"
 #include "rclcpp/rclcpp.hpp"
 #include "rclcpp_lifecycle/state.hpp"
-#include "realtime_tools/realtime_box.h"
 #include "realtime_tools/realtime_buffer.h"
 #include "realtime_tools/realtime_publisher.h"
+#include "sensor_msgs/msg/imu.hpp"
+#include "std_msgs/msg/float64_multi_array.hpp"
+#include "std_srvs/srv/trigger.hpp"
 #include "tf2_msgs/msg/tf_message.hpp"
 
 namespace ack_6wd_controller
@@ -56,6 +83,9 @@ public:
   ACK_6WD_CONTROLLER_PUBLIC
   Ack6WDController();
 
+  ACK_6WD_CONTROLLER_PUBLIC
+  ~Ack6WDController() override;
+
   ACK_6WD_CONTROLLER_PUBLIC
   controller_interface::return_type init(const std::string & controller_name) override;
 
@@ -88,16 +118,17 @@ public:
 
 protected:
   // Wheel variables
+  // State interfaces are nullptr when they are not claimed
   struct WheelHandle
   {
-    std::reference_wrapper<const hardware_interface::LoanedStateInterface> encoder_position;
-    std::reference_wrapper<const hardware_interface::LoanedStateInterface> encoder_velocity;
+    const hardware_interface::LoanedStateInterface * encoder_position;
+    const hardware_interface::LoanedStateInterface * encoder_velocity;
     std::reference_wrapper<hardware_interface::LoanedCommandInterface> velocity;
   };
 
   CallbackReturn configure_side_wheel(
-    const std::string & side, const std::vector<std::string> & wheel_names,
-    std::vector<WheelHandle> & registered_handles);
+    const std::string & side, const std::vector<std::string> & wheel_names, bool claim_position,
+    bool claim_velocity, std::vector<WheelHandle> & registered_handles);
 
   std::vector<std::string> left_wheel_names_;
   std::vector<std::string> right_wheel_names_;
@@ -110,8 +141,8 @@ protected:
   // Steering variables
   struct SteeringHandle
   {
-    std::reference_wrapper<const hardware_interface::LoanedStateInterface> encoder_position;
-    std::reference_wrapper<const hardware_interface::LoanedStateInterface> encoder_velocity;
+    const hardware_interface::LoanedStateInterface * encoder_position;
+    const hardware_interface::LoanedStateInterface * encoder_velocity;
     std::reference_wrapper<hardware_interface::LoanedCommandInterface> position;
   };
 
@@ -125,6 +156,151 @@ protected:
   std::vector<SteeringHandle> registered_left_steering_handles_;
   std::vector<SteeringHandle> registered_right_steering_handles_;
 
+  // State interfaces claimed, derived from the odometry mode and the enabled features
+  struct ClaimedStates
+  {
+    bool wheel_position = true;
+    bool wheel_velocity = true;
+    bool middle_wheel_position = true;
+    bool middle_wheel_velocity = true;
+    bool steering_position = true;
+    bool steering_velocity = true;
+  } claimed_states_;
+
+  const hardware_interface::LoanedStateInterface * find_state_interface(
+    const std::string & joint_name, const std::string & interface_name) const;
+
+  // Interfaces of all joints: left, right and middle wheels, then left and right steerings
+  std::vector<std::reference_wrapper<hardware_interface::LoanedCommandInterface>>
+    joint_command_interfaces_;
+  std::vector<const hardware_interface::LoanedStateInterface *> joint_state_interfaces_;
+
+  // controller units [rad/s], [rad] to the units of the interfaces and back
+  JointTransformTable joint_transforms_;
+  std::vector<double> joint_commands_;
+  std::vector<double> joint_states_;
+
+  // bitmask of the joints whose command changed, for hardware sending only those
+  struct ChangeMaskParams
+  {
+    bool enable = false;
+    std::string interface = "change_mask/mask";  // extra command interface, <name>/<interface>
+    double wheel_deadband = 0.0;                  // in the units of the command interfaces
+    double steering_deadband = 0.0;
+    int64_t refresh_cycles = 0;  // send unchanged joints at least this often, 0 for never
+  } change_mask_params_;
+
+  CommandChangeFilter change_filter_;
+  hardware_interface::LoanedCommandInterface * change_mask_interface_ = nullptr;
+
+  // stop and hold while a hardware state interface signals an e-stop
+  struct EstopParams
+  {
+    bool enable = false;
+    std::string interface = "safety/estop";  // extra state interface, <name>/<interface>
+    bool active_high = true;                 // engaged above 0.5, false for e.g. drive_enabled
+  } estop_params_;
+
+  const hardware_interface::LoanedStateInterface * estop_interface_ = nullptr;
+  bool estop_engaged_ = false;
+
+  // speed limits of areas in the odometry frame, see ZoneMap for the file format
+  struct ZoneMapParams
+  {
+    bool enable = false;
+    std::string file = "";
+    double resolution = 0.1;  // [m]
+    double margin = 0.0;      // [m] leave v^2 / (2 * max deceleration) to slow down in time
+  } zone_map_params_;
+
+  ZoneMap zone_map_;
+
+  static constexpr size_t MAX_WHEELS_PER_SIDE = 8;
+
+  // Wheel states read in a cycle and what the odometry needs to integrate them
+  struct EstimationInput
+  {
+    rclcpp::Time stamp{0};
+    double left_wheel_velocities[MAX_WHEELS_PER_SIDE] = {};
+    double right_wheel_velocities[MAX_WHEELS_PER_SIDE] = {};
+    double left_steering_angles[MAX_WHEELS_PER_SIDE] = {};
+    double right_steering_angles[MAX_WHEELS_PER_SIDE] = {};
+    double middle_wheel_velocities[2] = {};
+    double left_wheel_positions[MAX_WHEELS_PER_SIDE] = {};  // position odometry only
+    double right_wheel_positions[MAX_WHEELS_PER_SIDE] = {};
+    double middle_wheel_positions[2] = {};
+    double command_linear = 0.0;
+    double command_angular = 0.0;
+    double wheel_base = 0.0;
+    double wheel_separation = 0.0;
+    double left_wheel_radius = 0.0;
+    double right_wheel_radius = 0.0;
+    double wheel_radius = 0.0;
+    double steering_angle_correction = 0.0;
+    double angular_velocity_compensation = 0.0;
+  };
+
+  // Odometry state published by the control loop
+  struct OdometryEstimate
+  {
+    int64_t stamp_ns = 0;
+    double x = 0.0;
+    double y = 0.0;
+    double heading = 0.0;
+    double linear = 0.0;
+    double angular = 0.0;
+    uint32_t slip_mask = 0;
+    double suggested_wheel_radius = 0.0;
+    double suggested_steering_angle_correction = 0.0;
+    double suggested_angular_velocity_compensation = 0.0;
+  };
+
+  EstimationInput estimation_input_;
+  OdometryEstimate odometry_estimate_;
+
+  // odometry, slip detection and calibration off the control loop, a cycle behind
+  struct EstimationThreadParams
+  {
+    bool enable = false;
+    int64_t queue_size = 16;
+  } estimation_thread_params_;
+
+  ThreadSchedule estimation_thread_schedule_;
+  std::unique_ptr<SpscQueue<EstimationInput>> estimation_queue_;
+  Seqlock<OdometryEstimate> estimation_output_;
+  std::thread estimation_thread_;
+  std::atomic<bool> estimation_thread_running_{false};
+  sem_t estimation_semaphore_;  // counts the inputs pushed, initialized while the thread runs
+
+  struct SlipDetectionParams
+  {
+    bool enable = false;
+    double relative_tolerance = 0.15;
+    double absolute_tolerance = 0.05;  // [m/s]
+  } slip_detection_params_;
+
+  SlipDetector slip_detector_;
+
+  // commanded against measured joint values, joints in command interface order
+  struct TrackingMonitorParams
+  {
+    bool enable = false;
+    int64_t max_lag = 10;                   // [cycles]
+    double smoothing = 0.02;
+    double wheel_error_threshold = 0.0;     // [rpm], 0 to disable the warning
+    double steering_error_threshold = 0.0;  // [rad], 0 to disable the warning
+  } tracking_monitor_params_;
+
+  TrackingMonitor tracking_monitor_;
+  std::vector<double> written_commands_;
+  std::vector<double> measured_states_;
+  bool has_written_commands_ = false;
+
+  std::shared_ptr<rclcpp::Publisher<std_msgs::msg::Float64MultiArray>>
+    tracking_error_publisher_ = nullptr;
+  std::shared_ptr<realtime_tools::RealtimePublisher<std_msgs::msg::Float64MultiArray>>
+    realtime_tracking_error_publisher_ = nullptr;
+
   struct WheelParams
   {
     size_t wheels_per_side = 0;
@@ -139,9 +315,17 @@ protected:
     double steering_angle_correction = 1.0;
   } wheel_params_;
 
+  // what the steering can follow, see project_feasible_command()
+  struct FeasibleCommandParams
+  {
+    double max_steering_angle = M_PI / 2;  // [rad] of the inner wheels, the default is geometric
+    FeasibilityPolicy policy = PRESERVE_SPEED;
+  } feasible_command_params_;
+
   struct OdometryParams
   {
     bool open_loop = false;
+    bool use_positions = false;  // odometry_mode, integrate wheel positions instead of velocities
     bool enable_odom_tf = true;
     std::string base_frame_id = "base_link";
     std::string odom_frame_id = "odom";
@@ -151,6 +335,18 @@ protected:
 
   Odometry odometry_;
 
+  // odometry from the wheel encoder positions
+  struct PositionOdometryParams
+  {
+    double ticks_per_revolution = 4096.0;
+    // 0 for position interfaces in radians, ticks_per_revolution / (2 * pi), 1 for raw ticks
+    double ticks_per_position_unit = 0.0;
+    int64_t wrap_ticks = 0;                // range of the encoder counters, 0 if they do not wrap
+  } position_odometry_params_;
+
+  std::vector<TickAccumulator> wheel_ticks_;
+  std::vector<int64_t> integrated_ticks_;  // travel already integrated into the odometry
+
   std::shared_ptr<rclcpp::Publisher<nav_msgs::msg::Odometry>> odometry_publisher_ = nullptr;
   std::shared_ptr<realtime_tools::RealtimePublisher<nav_msgs::msg::Odometry>>
     realtime_odometry_publisher_ = nullptr;
@@ -164,11 +360,80 @@ protected:
   std::chrono::milliseconds cmd_vel_timeout_{500};
 
   bool subscriber_is_active_ = false;
-  rclcpp::Subscription<Twist>::SharedPtr velocity_command_subscriber_ = nullptr;
-  rclcpp::Subscription<geometry_msgs::msg::Twist>::SharedPtr
-    velocity_command_unstamped_subscriber_ = nullptr;
+  std::vector<rclcpp::Subscription<Twist>::SharedPtr> command_subscribers_;
+  std::vector<rclcpp::Subscription<geometry_msgs::msg::Twist>::SharedPtr>
+    command_unstamped_subscribers_;
+
+  // velocity command inputs, see command_inputs
+  CommandMux command_mux_;
+  std::vector<std::string> command_input_topics_;  // empty for the inputs fed in-process
+  size_t selected_command_input_ = 0;
+
+  // command input written through shared memory by a process on the same machine
+  SharedCommandChannel shared_command_channel_;
+  size_t shared_command_input_ = 0;
+
+  // velocity references commanded by other controllers in this controller_manager
+  InterfaceRegistry::InterfacePtr linear_velocity_reference_;
+  InterfaceRegistry::InterfacePtr angular_velocity_reference_;
+  size_t reference_input_ = 0;
+
+  // odometry read by other controllers in this controller_manager
+  struct OdometryStateInterfaces
+  {
+    InterfaceRegistry::InterfacePtr x;
+    InterfaceRegistry::InterfacePtr y;
+    InterfaceRegistry::InterfacePtr heading;
+    InterfaceRegistry::InterfacePtr linear_velocity;
+    InterfaceRegistry::InterfacePtr angular_velocity;
+  } odometry_state_interfaces_;
+
+  // pure pursuit on a path received as nav_msgs/Path, offered to the mux every cycle
+  struct PathTrackingParams
+  {
+    bool enable = false;
+    std::string topic = "~/path";
+    std::string input = "path";
+    int64_t max_points = 4096;
+    PurePursuit::Params pursuit;
+  } path_tracking_params_;
+  TripleBuffer<TrackedPath> path_buffer_;
+  PurePursuit pure_pursuit_;
+  size_t path_input_ = 0;
+  std::atomic<bool> discard_path_{false};  // set on deactivation, handled by update()
+  rclcpp::Subscription<nav_msgs::msg::Path>::SharedPtr path_subscriber_ = nullptr;
+
+  // full names in the InterfaceRegistry, released on reset
+  std::vector<std::string> exported_interface_names_;
+
+  // extrapolation of the selected input between its messages
+  struct CommandPredictionParams
+  {
+    bool enable = false;
+    int64_t order = 1;      // 0 holds, 1 linear, 2 quadratic
+    double max_gap = 0.25;  // [s], largest message spacing extrapolated from, fits 10 Hz input
+    double horizon = 0.1;   // [s], longest extrapolation past the last message
+  } command_prediction_params_;
+
+  CommandPredictor command_predictor_;
+
+  // cmd_vel reception on a dedicated executor thread
+  struct CommandThreadParams
+  {
+    bool enable = false;
+    int64_t priority = 0;                // SCHED_FIFO priority, 0 keeps the default scheduling
+    std::vector<int64_t> cpu_affinity;  // empty keeps the default affinity
+  } command_thread_params_;
+
+  rclcpp::Node::SharedPtr command_node_ = nullptr;
+  rclcpp::CallbackGroup::SharedPtr command_callback_group_ = nullptr;
+  std::shared_ptr<rclcpp::executors::SingleThreadedExecutor> command_executor_ = nullptr;
+  std::thread command_thread_;
+  std::atomic<bool> command_thread_running_{false};
 
-  realtime_tools::RealtimeBox<std::shared_ptr<Twist>> received_velocity_msg_ptr_{nullptr};
+  // scheduling of the helper threads, applied when they are created at configure
+  ThreadSchedule publisher_thread_schedule_;
+  ThreadSchedule logger_thread_schedule_;
 
   std::queue<Twist> previous_commands_;  // last two commands
 
@@ -181,6 +446,88 @@ protected:
   std::shared_ptr<realtime_tools::RealtimePublisher<Twist>> realtime_limited_velocity_publisher_ =
     nullptr;
 
+  // online wheel geometry calibration
+  struct CalibrationParams
+  {
+    bool enable = false;
+    std::string reference = "imu";  // "imu" or "odometry"
+    std::string reference_topic = "/imu";
+    double forgetting_factor = 0.999;
+    double min_linear_velocity = 0.1;
+    double min_angular_velocity = 0.05;
+  } calibration_params_;
+
+  // body velocity measured by the calibration reference
+  struct CalibrationReference
+  {
+    int64_t stamp_ns = 0;
+    double linear = 0.0;
+    double angular = 0.0;
+    bool has_linear = false;
+  };
+
+  OnlineCalibration calibration_;
+  realtime_tools::RealtimeBuffer<CalibrationReference> calibration_reference_;
+  int64_t last_calibration_reference_stamp_ns_ = 0;
+  nav_msgs::msg::Odometry previous_reference_pose_;
+
+  rclcpp::Subscription<sensor_msgs::msg::Imu>::SharedPtr calibration_imu_subscriber_ = nullptr;
+  rclcpp::Subscription<nav_msgs::msg::Odometry>::SharedPtr calibration_pose_subscriber_ =
+    nullptr;
+  std::shared_ptr<rclcpp::Publisher<std_msgs::msg::Float64MultiArray>>
+    calibration_publisher_ = nullptr;
+  std::shared_ptr<realtime_tools::RealtimePublisher<std_msgs::msg::Float64MultiArray>>
+    realtime_calibration_publisher_ = nullptr;
+
+  // last cycles of the controller, dumped on failure, overrun or request
+  struct FlightRecorderParams
+  {
+    bool enable = false;
+    std::string path = "/tmp/ack_6wd_controller_flight_record.bin";
+    int64_t capacity = 2000;  // [cycles]
+    double deadline = 0.0;    // [s] of execution time, 0 to disable
+  } flight_recorder_params_;
+
+  FlightRecorder flight_recorder_;
+  bool flight_recorder_failed_ = false;
+  bool flight_recorder_overran_ = false;
+  std::atomic<bool> flight_record_requested_{false};
+  rclcpp::Service<std_srvs::srv::Trigger>::SharedPtr flight_record_service_ = nullptr;
+
+  // every cycle of the flight recorder, written to a columnar log by a separate thread
+  struct TelemetryParams
+  {
+    bool enable = false;
+    std::string path = "/tmp/ack_6wd_controller_telemetry.tlm";
+    int64_t chunk_rows = 4096;
+    int64_t queue_size = 4096;
+    double velocity_step = 0.001;  // resolution of velocities [rpm, rad/s, m/s]
+    double position_step = 1e-5;   // resolution of positions [rad, m]
+    double time_step = 1e-6;       // resolution of periods and execution times [s]
+  } telemetry_params_;
+
+  TelemetryWriter telemetry_writer_;
+  TelemetrySample telemetry_sample_;
+
+  // windows of cycles around trigger events, in the telemetry format
+  struct CaptureParams
+  {
+    bool enable = false;
+    std::string path = "/tmp/ack_6wd_controller_capture.tlm";
+    std::vector<std::string> triggers = {
+      "error", "overrun", "invalid_state", "limiter_saturation", "cmd_vel_timeout",
+      "tracking_error"};
+    int64_t pre_trigger_cycles = 2000;
+    int64_t post_trigger_cycles = 2000;
+    double deadline = 0.0;  // [s] of execution time for the overrun trigger, 0 to disable
+    int64_t queue_size = 4096;
+  } capture_params_;
+
+  CaptureWindow capture_window_;
+  uint32_t capture_trigger_mask_ = 0;
+  TelemetryWriter capture_writer_;
+  TelemetrySample capture_sample_;
+
   rclcpp::Time previous_update_timestamp_{0};
 
   // publish rate limiter
@@ -193,8 +540,42 @@ protected:
 
   bool reset();
   void halt();
-
-  int quadrant(double linear, double angular);
+  void write_joint_commands();
+
+  controller_interface::return_type update_cycle();
+  void record_flight_state(FlightRecord & record) const;
+  void fill_telemetry_sample(const FlightRecord & record, TelemetrySample & sample) const;
+
+  void configure_calibration();
+  void estimate(EstimationInput & input, OdometryEstimate & output);
+  void integrate_wheel_positions(const EstimationInput & input);
+  void start_estimation_thread();
+  void stop_estimation_thread();
+  CallbackReturn configure_estimation_thread();
+  void start_command_thread();
+  void stop_command_thread();
+  void configure_claimed_states();
+  CallbackReturn configure_command_mux();
+  void offer_command(size_t input, const MuxCommand & command);
+  CallbackReturn configure_reference_interfaces();
+  CallbackReturn configure_odometry_state_interfaces();
+  CallbackReturn configure_path_tracking();
+  CallbackReturn configure_estop();
+  CallbackReturn configure_zone_map();
+  CallbackReturn configure_feasible_command();
+  void receive_path(const nav_msgs::msg::Path & path);
+  // Drop the path after a deactivation, from the control loop, true when it did
+  bool discard_path();
+  InterfaceRegistry::InterfacePtr export_interface(const std::string & interface_name, double value);
+  void unexport_interfaces();
+  CallbackReturn configure_joint_transforms();
+  CallbackReturn configure_change_mask();
+  CallbackReturn configure_tracking_monitor();
+  CallbackReturn configure_flight_recorder();
+  CallbackReturn configure_telemetry();
+  CallbackReturn configure_capture();
+  std::vector<TelemetryColumn> telemetry_columns() const;
+  void update_tracking_monitor(double period);
 };
 }  // namespace ack_6wd_controller
 #endif  // ACK_6WD_CONTROLLER__ACK_6WD_CONTROLLER_HPP_
@@ -0,0 +1,120 @@
+// Copyright 2021 Faiz Pangestu
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Maintainer : Faiz Pangestu
+ */
+
+#ifndef ACK_6WD_CONTROLLER__CALIBRATION_SOLVER_HPP_
+#define ACK_6WD_CONTROLLER__CALIBRATION_SOLVER_HPP_
+
+#include <array>
+#include <vector>
+
+#include "ack_6wd_controller/joint_state_log.hpp"
+#include "ack_6wd_controller/pose_log.hpp"
+
+namespace ack_6wd_controller
+{
+// Wheel geometry parameters, named like the controller parameters
+struct CalibrationParameters
+{
+  double wheel_radius = 0.0;
+  double wheel_separation = 0.0;
+  double wheel_base = 0.0;
+  double left_wheel_radius_multiplier = 1.0;
+  double right_wheel_radius_multiplier = 1.0;
+  double steering_angle_correction = 1.0;
+};
+
+// Wheel state of one control cycle, both sides kept apart
+struct CalibrationSample
+{
+  double stamp;           //   [s]
+  double left_velocity;   // [rad/s], mean of the left wheels, signed with the motion
+  double right_velocity;  // [rad/s], mean of the right wheels, signed with the motion
+  double angle;           //   [rad], fused steering angle before correction
+};
+
+/**
+ * \brief Extract calibration samples from a joint state log
+ *
+ * Same joint order and fusion as fuse_joint_state_log, rows with an invalid state are dropped.
+ */
+std::vector<CalibrationSample> make_calibration_samples(
+  const JointStateLog & log, size_t wheels_per_side, double velocity_scale);
+
+/**
+ * \brief Batch fit of the wheel geometry to ground truth poses
+ *
+ * The recording is cut into windows of ground truth poses. In every window the wheel samples
+ * are integrated with the Ackermann model of the odometry, using both sides, and the relative
+ * motion is compared with the ground truth one. The parameters are found with
+ * Levenberg-Marquardt on these residuals, the windows being evaluated concurrently.
+ * A weak prior towards the initial parameters keeps the radius and its multipliers apart.
+ */
+class CalibrationSolver
+{
+public:
+  struct Options
+  {
+    double window_duration = 1.0;  // [s]
+    double heading_weight = 1.0;   // [m/rad]
+    double prior_weight = 1e-6;
+    size_t max_iterations = 100;
+    size_t thread_count = 1;
+  };
+
+  struct Summary
+  {
+    double initial_cost = 0.0;
+    double final_cost = 0.0;
+    size_t iterations = 0;
+    size_t window_count = 0;
+  };
+
+  CalibrationSolver(
+    std::vector<CalibrationSample> samples, const PoseLog & ground_truth, const Options & options);
+
+  CalibrationParameters solve(const CalibrationParameters & initial, Summary & summary) const;
+
+  /**
+   * \brief Residuals of the ground truth windows, 3 per window, priors excluded
+   */
+  void evaluate(const CalibrationParameters & parameters, std::vector<double> & residuals) const;
+
+private:
+  static constexpr size_t PARAMETER_COUNT = 6;
+  using Vector = std::array<double, PARAMETER_COUNT>;
+
+  struct Window
+  {
+    size_t first_sample;
+    size_t end_sample;
+    double start_stamp;
+    double end_stamp;
+    Pose2D relative_motion;
+  };
+
+  void evaluate_with_prior(
+    const Vector & parameters, const Vector & prior, std::vector<double> & residuals) const;
+
+  std::vector<CalibrationSample> samples_;
+  std::vector<Window> windows_;
+  Options options_;
+};
+
+}  // namespace ack_6wd_controller
+
+#endif  // ACK_6WD_CONTROLLER__CALIBRATION_SOLVER_HPP_
@@ -0,0 +1,75 @@
+// Copyright 2021 Faiz Pangestu
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Maintainer : Faiz Pangestu
+ */
+
+#ifndef ACK_6WD_CONTROLLER__CAPTURE_WINDOW_HPP_
+#define ACK_6WD_CONTROLLER__CAPTURE_WINDOW_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "ack_6wd_controller/flight_recorder.hpp"
+
+namespace ack_6wd_controller
+{
+/**
+ * \brief Selects the cycles around trigger events for persisting
+ *
+ * Every cycle goes through a delay line long enough for the pre-trigger window. A trigger
+ * makes the window before it and the cycles up to post_cycles after it pending, a trigger
+ * during a capture extends it. Pending records are handed out oldest first by pop(), a few per
+ * cycle so the backlog of the pre-trigger window is spread over the following cycles. Memory
+ * is allocated at configure.
+ */
+class CaptureWindow
+{
+public:
+  /**
+   * \param [in] pre_cycles  Cycles kept before a trigger
+   * \param [in] post_cycles Cycles kept after a trigger
+   */
+  void configure(size_t pre_cycles, size_t post_cycles);
+
+  void reset();
+
+  // Add the record of this cycle, triggered if it should be captured with its surroundings
+  void push(const FlightRecord & record, bool triggered);
+
+  // Oldest pending record, nullptr if there is none. Valid until the next push().
+  const FlightRecord * pop();
+
+  bool isCapturing() const { return next_ < end_; }
+
+  // Captures started since configure
+  uint64_t getCaptureCount() const { return capture_count_; }
+
+private:
+  std::vector<FlightRecord> ring_;
+  size_t pre_cycles_ = 0;
+  size_t post_cycles_ = 0;
+
+  // sequence numbers of the records, record n is in ring_[n % ring_.size()]
+  uint64_t pushed_ = 0;  // records pushed
+  uint64_t next_ = 0;    // next record to hand out
+  uint64_t end_ = 0;     // end of the capture, exclusive
+  uint64_t capture_count_ = 0;
+};
+
+}  // namespace ack_6wd_controller
+
+#endif  // ACK_6WD_CONTROLLER__CAPTURE_WINDOW_HPP_
@@ -0,0 +1,73 @@
+// Copyright 2021 Faiz Pangestu
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Maintainer : Faiz Pangestu
+ */
+
+
+#ifndef ACK_6WD_CONTROLLER__CHANGE_FILTER_HPP_
+#define ACK_6WD_CONTROLLER__CHANGE_FILTER_HPP_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ack_6wd_controller
+{
+/**
+ * \brief Tracks which joint commands changed enough to be worth sending
+ *
+ * A joint is dirty when its command moved by more than its deadband from the last value sent
+ * for it, when it becomes exactly 0 (a stop is never swallowed by the deadband), or when it has
+ * not been sent for refresh_cycles cycles. Clean joints keep the value sent last, so the
+ * command interfaces always hold what the drives are executing.
+ */
+class CommandChangeFilter
+{
+public:
+  static constexpr size_t MAX_JOINTS = 32;
+
+  /**
+   * \param [in]  deadbands      One per joint, in the units of the command interfaces
+   * \param [in]  refresh_cycles Cycles after which a clean joint is sent anyway, 0 for never
+   * \param [out] error          Why the configuration was rejected
+   * \return false for more than MAX_JOINTS joints or a negative deadband
+   */
+  bool configure(const std::vector<double> & deadbands, size_t refresh_cycles, std::string & error);
+
+  // Every joint is dirty on the next update
+  void reset();
+
+  /**
+   * \brief Update the mask and hold the commands of the clean joints
+   * \param [in, out] values One command per joint
+   * \return Bit i set when joint i has to be sent
+   */
+  uint32_t update(double * values);
+
+  uint32_t getMask() const { return mask_; }
+
+private:
+  std::vector<double> deadbands_;
+  std::vector<double> sent_;
+  std::vector<size_t> age_;  // cycles since the joint was last sent
+  size_t refresh_cycles_ = 0;
+  bool has_sent_ = false;
+  uint32_t mask_ = 0;
+};
+
+}  // namespace ack_6wd_controller
+
+#endif  // ACK_6WD_CONTROLLER__CHANGE_FILTER_HPP_
@@ -0,0 +1,135 @@
+// Copyright 2021 Faiz Pangestu
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Maintainer : Faiz Pangestu
+ */
+
+
+#ifndef ACK_6WD_CONTROLLER__COMMAND_MUX_HPP_
+#define ACK_6WD_CONTROLLER__COMMAND_MUX_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ack_6wd_controller/seqlock.hpp"
+
+namespace ack_6wd_controller
+{
+// Velocity command of one input of the mux
+struct MuxCommand
+{
+  int64_t stamp_ns = 0;  // 0 when nothing was received yet
+  double linear = 0.0;   // [m/s]
+  double angular = 0.0;  // [rad/s]
+};
+
+/**
+ * \brief Arbitration of several velocity command inputs by priority
+ *
+ * Every input has a mailbox holding its latest command. Offering a command never waits, so
+ * it may be done from any thread, one writer per input. Each cycle the command of the input
+ * with the highest priority which is not older than its timeout is selected.
+ *
+ * Optionally the stamps of an input have to increase while its command is fresh: a command
+ * stamped like the held one is a duplicate, one stamped before it by more than the tolerance
+ * was reordered on the way, and both are rejected. Once the held command timed out any
+ * stamp is accepted again, so a restarted publisher is not locked out.
+ */
+class CommandMux
+{
+public:
+  enum OfferResult
+  {
+    OFFER_ACCEPTED,
+    OFFER_DUPLICATE,
+    OFFER_REORDERED,
+  };
+
+  struct Input
+  {
+    std::string name;
+    int64_t priority = 0;    // higher wins
+    int64_t timeout_ns = 0;  // commands older than this are ignored
+  };
+
+  /**
+   * \brief Allocate the mailboxes, all inputs start empty
+   * \param [in]  inputs Inputs, names must be unique
+   * \param [out] error  Why the inputs were rejected
+   */
+  bool configure(const std::vector<Input> & inputs, std::string & error);
+
+  /**
+   * \brief Enforce increasing stamps in offer()
+   * \param [in] enable       false accepts every command
+   * \param [in] tolerance_ns How far a stamp may go back without being rejected [ns]
+   */
+  void setStampCheck(bool enable, int64_t tolerance_ns);
+
+  size_t size() const { return inputs_.size(); }
+  const Input & getInput(size_t index) const { return inputs_[index]; }
+
+  // Index of the input with this name, size() if there is none
+  size_t find(const std::string & name) const;
+
+  /**
+   * \brief Latest command of an input, wait-free
+   * \param [in] index   Input, one writer per input
+   * \param [in] command Command, with the stamp it was issued at
+   * \param [in] now_ns  Current time [ns], tells whether the held command timed out
+   */
+  OfferResult offer(size_t index, const MuxCommand & command, int64_t now_ns);
+
+  // Commands of an input rejected so far
+  uint64_t getDuplicateCount(size_t index) const
+  {
+    return duplicates_[index].load(std::memory_order_relaxed);
+  }
+  uint64_t getReorderedCount(size_t index) const
+  {
+    return reordered_[index].load(std::memory_order_relaxed);
+  }
+
+  // Forget the commands of all inputs
+  void clear();
+
+  /**
+   * \brief Select the command of this cycle
+   * \param [in]  now_ns  Current time [ns]
+   * \param [out] command Command of the selected input, zero velocity when none is fresh
+   * \return Index of the selected input, size() when all are stale
+   */
+  size_t select(int64_t now_ns, MuxCommand & command);
+
+private:
+  std::vector<Input> inputs_;
+  std::vector<size_t> order_;  // input indices by decreasing priority
+  std::unique_ptr<Seqlock<MuxCommand>[]> mailboxes_;
+  // last complete read of each mailbox, select() never waits on a preempted writer
+  std::vector<MuxCommand> snapshots_;
+
+  bool check_stamps_ = false;
+  int64_t stamp_tolerance_ns_ = 0;
+  std::vector<int64_t> newest_stamps_;  // written by the writer of each input only
+  std::unique_ptr<std::atomic<uint64_t>[]> duplicates_;
+  std::unique_ptr<std::atomic<uint64_t>[]> reordered_;
+};
+
+}  // namespace ack_6wd_controller
+
+#endif  // ACK_6WD_CONTROLLER__COMMAND_MUX_HPP_
@@ -0,0 +1,79 @@
+// Copyright 2021 Faiz Pangestu
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Maintainer : Faiz Pangestu
+ */
+
+
+#ifndef ACK_6WD_CONTROLLER__COMMAND_PREDICTOR_HPP_
+#define ACK_6WD_CONTROLLER__COMMAND_PREDICTOR_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace ack_6wd_controller
+{
+/**
+ * \brief Extrapolation of a velocity command between the arrivals of its messages
+ *
+ * A polynomial of the configured order through the last commands is evaluated at the current
+ * time, up to horizon past the last command. The last command is returned instead when fewer
+ * commands than needed are known, when they are further apart than max_gap, since they say
+ * little about the motion then, and once the horizon has passed, since the input is late
+ * rather than between messages then. An extrapolation never changes the sign of the last
+ * command, so a vehicle slowing down to a stop is never sent backwards.
+ */
+class CommandPredictor
+{
+public:
+  static constexpr size_t MAX_ORDER = 2;
+
+  /**
+   * \param [in] order   0 holds the last command, 1 is linear, 2 quadratic
+   * \param [in] max_gap Largest spacing of the commands an extrapolation uses [s]
+   * \param [in] horizon Longest extrapolation past the last command [s]
+   */
+  void configure(size_t order, double max_gap, double horizon);
+
+  // Forget the commands, e.g. when they come from another source
+  void reset();
+
+  // Add a command, ignored unless it is newer than the last one
+  void add(int64_t stamp_ns, double linear, double angular);
+
+  /**
+   * \brief Command at a time
+   * \param [in]  now_ns  Time to predict at [ns]
+   * \param [out] linear  [m/s], 0 when no command was added
+   * \param [out] angular [rad/s], 0 when no command was added
+   */
+  void predict(int64_t now_ns, double & linear, double & angular) const;
+
+private:
+  size_t order_ = 0;
+  int64_t max_gap_ns_ = 0;
+  int64_t horizon_ns_ = 0;
+
+  // last commands, newest first
+  std::array<int64_t, MAX_ORDER + 1> stamps_{};
+  std::array<double, MAX_ORDER + 1> linear_{};
+  std::array<double, MAX_ORDER + 1> angular_{};
+  size_t count_ = 0;
+};
+
+}  // namespace ack_6wd_controller
+
+#endif  // ACK_6WD_CONTROLLER__COMMAND_PREDICTOR_HPP_
@@ -0,0 +1,167 @@
+// Copyright 2021 Faiz Pangestu
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Maintainer : Faiz Pangestu
+ */
+
+#ifndef ACK_6WD_CONTROLLER__FLIGHT_RECORDER_HPP_
+#define ACK_6WD_CONTROLLER__FLIGHT_RECORDER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ack_6wd_controller
+{
+// Joints a record has room for
+constexpr size_t FLIGHT_RECORD_MAX_JOINTS = 16;
+
+// Noteworthy conditions of a cycle, FlightRecord::events bits
+enum FlightRecordEvent : uint32_t
+{
+  EVENT_ERROR = 1u << 0,               // update() returned ERROR
+  EVENT_OVERRUN = 1u << 1,             // execution time above the deadline
+  EVENT_INVALID_STATE = 1u << 2,       // NaN on a state interface
+  EVENT_LIMITER_SATURATION = 1u << 3,  // the speed limiter changed the command
+  EVENT_COMMAND_TIMEOUT = 1u << 4,     // cmd_vel timed out
+  EVENT_TRACKING_ERROR = 1u << 5,      // a joint exceeded its tracking error threshold
+  EVENT_ESTOP = 1u << 6,               // the hardware e-stop is engaged
+};
+
+/**
+ * \brief Inputs and outputs of one controller cycle
+ *
+ * Plain data so it can be copied to the dump file as is. Joints follow the command interface
+ * order: left wheels, right wheels, middle wheels, left steerings, right steerings. Wheel values
+ * are in rpm, steering values in rad, as on the interfaces.
+ */
+struct FlightRecord
+{
+  int64_t stamp_ns;
+  double period;          // time since the previous cycle [s]
+  double execution_time;  // time spent in update() [s]
+  int32_t result;         // controller_interface::return_type
+  uint32_t joint_count;
+  uint32_t events;        // FlightRecordEvent bits
+  uint32_t reserved;
+
+  // command received on cmd_vel, after the timeout check
+  double command_linear;
+  double command_angular;
+  // command sent to the wheels, after the speed limiter
+  double limited_linear;
+  double limited_angular;
+
+  double joint_positions[FLIGHT_RECORD_MAX_JOINTS];
+  double joint_velocities[FLIGHT_RECORD_MAX_JOINTS];
+  double joint_commands[FLIGHT_RECORD_MAX_JOINTS];
+
+  double odometry_x;
+  double odometry_y;
+  double odometry_heading;
+  double odometry_linear;
+  double odometry_angular;
+};
+
+/**
+ * \brief Start of the dump file, followed by record_count records, oldest first
+ */
+struct FlightRecordHeader
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t record_size;
+  uint64_t capacity;
+  uint64_t record_count;
+  int64_t dump_stamp_ns;
+  uint32_t reason;  // FlightRecorder::DumpReason
+  uint32_t sequence;  // incremented on every dump
+};
+
+/**
+ * \brief Fixed size ring of the last cycles of the controller, dumped to a file on demand
+ *
+ * All memory, including the file mapping the dump is copied to, is set up at configure. Filling
+ * the current record, committing it and dumping the ring only copy memory, so they can run in
+ * the control loop. The file always holds the latest dump.
+ */
+class FlightRecorder
+{
+public:
+  enum DumpReason : uint32_t
+  {
+    DUMP_ON_ERROR = 1,
+    DUMP_ON_DEADLINE_MISS = 2,
+    DUMP_ON_REQUEST = 3,
+  };
+
+  FlightRecorder() = default;
+  ~FlightRecorder();
+
+  FlightRecorder(const FlightRecorder &) = delete;
+  FlightRecorder & operator=(const FlightRecorder &) = delete;
+
+  /**
+   * \brief Allocate the ring and map the dump file
+   * \param [in]  path     Dump file, created or truncated
+   * \param [in]  capacity Cycles kept
+   * \param [out] error    Reason of a failure
+   * \return False on failure, the recorder is then unusable
+   */
+  bool configure(const std::string & path, size_t capacity, std::string & error);
+
+  // Unmap the dump file and free the ring
+  void release();
+
+  bool isConfigured() const { return mapping_ != nullptr; }
+
+  // Record of the running cycle, cleared by begin()
+  FlightRecord & current() { return current_; }
+
+  void begin();
+
+  // Append the current record to the ring
+  void commit();
+
+  // Copy the ring to the dump file
+  void dump(DumpReason reason, int64_t stamp_ns);
+
+private:
+  std::vector<FlightRecord> ring_;
+  size_t head_ = 0;   // next slot written
+  size_t count_ = 0;  // records in the ring
+  FlightRecord current_{};
+
+  int file_descriptor_ = -1;
+  void * mapping_ = nullptr;
+  size_t mapping_size_ = 0;
+  uint32_t sequence_ = 0;
+};
+
+/**
+ * \brief Read a dump file written by FlightRecorder
+ * \param [in]  path    Dump file
+ * \param [out] header  File header
+ * \param [out] records Records, oldest first
+ * \param [out] error   Reason of a failure
+ */
+bool read_flight_record(
+  const std::string & path, FlightRecordHeader & header, std::vector<FlightRecord> & records,
+  std::string & error);
+
+}  // namespace ack_6wd_controller
+
+#endif  // ACK_6WD_CONTROLLER__FLIGHT_RECORDER_HPP_
@@ -0,0 +1,103 @@
+// Copyright 2021 Faiz Pangestu
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Maintainer : Faiz Pangestu
+ */
+
+#ifndef ACK_6WD_CONTROLLER__INTERFACE_REGISTRY_HPP_
+#define ACK_6WD_CONTROLLER__INTERFACE_REGISTRY_HPP_
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace ack_6wd_controller
+{
+/**
+ * \brief One double exported by a controller to the other controllers of its process
+ *
+ * Reading and writing never block, so both sides may use it from their update loop.
+ */
+class ExportedInterface
+{
+public:
+  explicit ExportedInterface(double value) : value_(value) {}
+
+  // false where a double is not atomic without a lock, exportInterface() refuses then
+  bool isLockFree() const { return value_.is_lock_free(); }
+
+  double get() const { return value_.load(std::memory_order_acquire); }
+
+  void set(double value) { value_.store(value, std::memory_order_release); }
+
+  // Returns the current value and replaces it
+  double exchange(double value) { return value_.exchange(value, std::memory_order_acq_rel); }
+
+private:
+  std::atomic<double> value_;
+};
+
+/**
+ * \brief Interfaces exported by the controllers loaded into one controller_manager
+ *
+ * Stands in for the reference and state interfaces of chainable controllers, which the
+ * controller_manager of this distribution does not have. Names follow the ros2_control
+ * convention "<controller>/<interface>". Exporting and finding take a lock and belong into
+ * configure and activate, the interfaces themselves are used from the update loop.
+ */
+class InterfaceRegistry
+{
+public:
+  using InterfacePtr = std::shared_ptr<ExportedInterface>;
+
+  static InterfaceRegistry & instance();
+
+  /**
+   * \brief Export a new interface
+   * \param [in] name Full name of the interface
+   * \param [in] value Initial value
+   * \param [out] error Reason when nullptr is returned, which is when the name is taken or
+   *  the interface would need a lock
+   */
+  InterfacePtr exportInterface(const std::string & name, double value, std::string & error);
+
+  /**
+   * \brief Stop exporting an interface, holders of it keep a valid but orphaned interface
+   * \param [in] name Full name of the interface
+   */
+  void unexportInterface(const std::string & name);
+
+  /**
+   * \brief Interface exported under a name
+   * \param [in] name Full name of the interface
+   * \return nullptr when nothing is exported under that name
+   */
+  InterfacePtr findInterface(const std::string & name) const;
+
+  std::vector<std::string> getNames() const;
+
+private:
+  InterfaceRegistry() = default;
+
+  mutable std::mutex mutex_;
+  std::map<std::string, InterfacePtr> interfaces_;
+};
+
+}  // namespace ack_6wd_controller
+
+#endif  // ACK_6WD_CONTROLLER__INTERFACE_REGISTRY_HPP_
@@ -0,0 +1,73 @@
+// Copyright 2021 Faiz Pangestu
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Maintainer : Faiz Pangestu
+ */
+
+#ifndef ACK_6WD_CONTROLLER__JOINT_STATE_LOG_HPP_
+#define ACK_6WD_CONTROLLER__JOINT_STATE_LOG_HPP_
+
+#include <string>
+#include <vector>
+
+#include "rclcpp/time.hpp"
+
+namespace ack_6wd_controller
+{
+/**
+ * \brief Recorded states of a fixed set of joints, one row per recorded message
+ *
+ * positions and velocities are row-major with joint_names.size() entries per row.
+ */
+struct JointStateLog
+{
+  std::vector<std::string> joint_names;
+  std::vector<rclcpp::Time> stamps;
+  std::vector<double> positions;
+  std::vector<double> velocities;
+
+  size_t size() const { return stamps.size(); }
+  const double * position_row(size_t row) const { return &positions[row * joint_names.size()]; }
+  const double * velocity_row(size_t row) const { return &velocities[row * joint_names.size()]; }
+};
+
+/**
+ * \brief Read the sensor_msgs/JointState messages of a rosbag2 recording
+ * \param [in]  uri         Bag directory
+ * \param [in]  topic       Joint state topic
+ * \param [in]  joint_names Joints to extract, in the order they are stored in the log
+ * \param [out] log         Extracted states, messages missing one of the joints are skipped
+ * \param [out] error       Reason of the failure
+ * \return false if the bag could not be read
+ */
+bool read_joint_state_log(
+  const std::string & uri, const std::string & topic,
+  const std::vector<std::string> & joint_names, JointStateLog & log, std::string & error);
+
+/**
+ * \brief Read the joint states of a telemetry log written by the controller
+ * \param [in]  path        Telemetry log
+ * \param [in]  joint_names Joints to extract, in the order they are stored in the log
+ * \param [out] log         Extracted states, in the units of the interfaces
+ * \param [out] error       Reason of the failure
+ * \return false if the log could not be read or misses one of the joints
+ */
+bool read_joint_state_telemetry(
+  const std::string & path, const std::vector<std::string> & joint_names, JointStateLog & log,
+  std::string & error);
+
+}  // namespace ack_6wd_controller
+
+#endif  // ACK_6WD_CONTROLLER__JOINT_STATE_LOG_HPP_
@@ -0,0 +1,93 @@
+// Copyright 2021 Faiz Pangestu
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Maintainer : Faiz Pangestu
+ */
+
+
+#ifndef ACK_6WD_CONTROLLER__JOINT_TRANSFORM_HPP_
+#define ACK_6WD_CONTROLLER__JOINT_TRANSFORM_HPP_
+
+#include <cstddef>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace ack_6wd_controller
+{
+/**
+ * \brief Map of one joint between the controller units and its hardware interface
+ *
+ * hardware = clamp(sign * scale * controller + offset, lower_limit, upper_limit)
+ */
+struct JointTransform
+{
+  double scale = 1.0;
+  double sign = 1.0;
+  double offset = 0.0;
+  double lower_limit = -std::numeric_limits<double>::infinity();
+  double upper_limit = std::numeric_limits<double>::infinity();
+};
+
+/**
+ * \brief Output transforms of all joints, applied to flat arrays in one pass
+ *
+ * Joints are in the order the controller flattens them: left wheels, right wheels, middle
+ * wheels, left steerings, right steerings. Commands go through apply(), the states read back
+ * through invert(), which leaves out the clamp.
+ */
+class JointTransformTable
+{
+public:
+  /**
+   * \brief Precompute the table
+   * \param [in]  transforms One per joint
+   * \param [out] error      Why the transforms were rejected
+   * \return false when a scale is zero or not finite, a sign is not +-1 or a lower limit is
+   *  above the upper one
+   */
+  bool configure(const std::vector<JointTransform> & transforms, std::string & error);
+
+  size_t size() const { return gains_.size(); }
+
+  // Direction of a joint, -1 when the hardware counts it backwards
+  double getSign(size_t index) const { return gains_[index] < 0.0 ? -1.0 : 1.0; }
+
+  /**
+   * \brief Hardware values of controller values
+   * \param [in]  values  size() controller values
+   * \param [out] outputs size() hardware values, may alias values
+   */
+  void apply(const double * values, double * outputs) const;
+
+  /**
+   * \brief Controller values of hardware values, without the clamp
+   * \param [in]  values  size() hardware values
+   * \param [out] outputs size() controller values, may alias values
+   */
+  void invert(const double * values, double * outputs) const;
+
+private:
+  // sign and scale folded together
+  std::vector<double> gains_;
+  std::vector<double> inverse_gains_;
+  std::vector<double> offsets_;
+  std::vector<double> lower_limits_;
+  std::vector<double> upper_limits_;
+};
+
+}  // namespace ack_6wd_controller
+
+#endif  // ACK_6WD_CONTROLLER__JOINT_TRANSFORM_HPP_
@@ -0,0 +1,130 @@
+// Copyright 2021 Faiz Pangestu
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Maintainer : Faiz Pangestu
+ */
+
+#ifndef ACK_6WD_CONTROLLER__KINEMATICS_HPP_
+#define ACK_6WD_CONTROLLER__KINEMATICS_HPP_
+
+#include <cstddef>
+
+namespace ack_6wd_controller
+{
+// Conversion applied to the drive velocities read back from the hardware [rpm -> rad/s]
+constexpr double RPM_TO_RAD_PER_SEC = 2 * 3.14159265358979323846 / 60;
+
+/**
+ * \brief Quadrant of a (linear, angular) pair
+ *
+ *   0 | 1
+ *   -----
+ *   3 | 2
+ */
+int quadrant(double linear, double angular);
+
+/**
+ * \brief Fuse the wheel velocities and steering angles of both sides into the
+ *  (steering angle, wheel velocity) pair consumed by Odometry::updateVel
+ *
+ * The direction of motion is taken from the first left wheel, the magnitude from the
+ * slowest side and the steering from the most deflected side.
+ *
+ * \param [in]  left_velocities  Left wheel velocities [rad/s], wheels_per_side entries
+ * \param [in]  right_velocities Right wheel velocities [rad/s], wheels_per_side entries
+ * \param [in]  left_angles      Left steering angles [rad], wheels_per_side entries
+ * \param [in]  right_angles     Right steering angles [rad], wheels_per_side entries
+ * \param [in]  wheels_per_side  Number of entries per side, must be > 0
+ * \param [out] angle            Fused steering angle [rad]
+ * \param [out] velocity         Fused wheel velocity [rad/s]
+ */
+void fuse_wheel_states(
+  const double * left_velocities, const double * right_velocities, const double * left_angles,
+  const double * right_angles, size_t wheels_per_side, double & angle, double & velocity);
+
+/**
+ * \brief Least squares displacement of the base from the distance rolled by its wheels
+ *
+ * A wheel at (x, y) in the base frame steered by angle rolls
+ *   cos(angle) * linear + (x * sin(angle) - y * cos(angle)) * angular
+ * when the base, turning about a center on its y axis, moves by (linear, angular).
+ *
+ * \param [in]  distances Distance rolled by each wheel [m]
+ * \param [in]  angles    Steering angle of each wheel [rad], 0 for the fixed wheels
+ * \param [in]  x         Longitudinal position of each wheel [m], forward positive
+ * \param [in]  y         Lateral position of each wheel [m], left positive
+ * \param [in]  count     Number of wheels
+ * \param [out] linear    Distance travelled by the base [m]
+ * \param [out] angular   Rotation of the base [rad]
+ * \return false when the wheels do not determine the motion, e.g. all on one line
+ */
+bool fit_base_displacement(
+  const double * distances, const double * angles, const double * x, const double * y,
+  size_t count, double & linear, double & angular);
+
+/**
+ * \brief Ground speed of the wheels relative to the inner steered wheels
+ *
+ * Follows the inverse kinematics of the controller for the turn given by the steering angle
+ * of the inner steered wheels. All ratios are 1 when driving straight.
+ *
+ * \param [in]  angle            Inner steering angle [rad], sign ignored
+ * \param [in]  wheel_base       Wheel base [m]
+ * \param [in]  wheel_separation Wheel separation [m]
+ * \param [out] steered_outer    Outer steered wheels
+ * \param [out] middle_inner     Inner middle wheel
+ * \param [out] middle_outer     Outer middle wheel
+ */
+void wheel_speed_ratios(
+  double angle, double wheel_base, double wheel_separation, double & steered_outer,
+  double & middle_inner, double & middle_outer);
+
+/**
+ * \brief Smallest turning radius of the inverse kinematics, reached at the steering limit
+ *
+ * \param [in]  wheel_base         Wheel base [m]
+ * \param [in]  wheel_separation   Wheel separation [m]
+ * \param [in]  max_steering_angle Largest angle of the inner steered wheels [rad], in (0, pi/2]
+ * \return Turning radius of the base [m]
+ */
+double minimum_turning_radius(
+  double wheel_base, double wheel_separation, double max_steering_angle);
+
+// How project_feasible_command() moves a turn tighter than the minimum turning radius
+enum FeasibilityPolicy
+{
+  PRESERVE_SPEED,      // keep the linear velocity, turn at the minimum radius
+  PRESERVE_CURVATURE,  // keep the angular velocity, drive as fast as the minimum radius needs
+};
+
+/**
+ * \brief Move a velocity command into the set the steering can follow
+ *
+ * A turn on the spot, angular without linear velocity, is moved forward under
+ * PRESERVE_CURVATURE and becomes a stop under PRESERVE_SPEED. Commands pass unchanged when
+ * min_radius is not > 0.
+ *
+ * \param [in]      min_radius Minimum turning radius [m]
+ * \param [in]      policy     What to keep of the command
+ * \param [in, out] linear     Linear velocity [m/s]
+ * \param [in, out] angular    Angular velocity [rad/s]
+ * \return true when the command was changed
+ */
+bool project_feasible_command(
+  double min_radius, FeasibilityPolicy policy, double & linear, double & angular);
+
+}  // namespace ack_6wd_controller
+
+#endif  // ACK_6WD_CONTROLLER__KINEMATICS_HPP_
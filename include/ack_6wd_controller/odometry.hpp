@@ -37,7 +37,7 @@ public:
   explicit Odometry(size_t velocity_rolling_window_size = 10);
 
   void init(const rclcpp::Time & time);
-  bool update(double left_pos, double right_pos, const rclcpp::Time & time);
+  bool updateDisplacement(double linear, double angular, const rclcpp::Time & time);
   void updateOpenLoop(double linear, double angular, const rclcpp::Time & time);
   void updateVel(double angle, double velocity, const rclcpp::Time & time);
   void resetOdometry();
@@ -81,10 +81,6 @@ private:
   double left_wheel_radius_;
   double right_wheel_radius_;
 
-  // Previous wheel position/state [rad]:
-  double left_wheel_old_pos_;
-  double right_wheel_old_pos_;
-
   // Rolling mean accumulators for the linear and angular velocities:
   size_t velocity_rolling_window_size_;
   RollingMeanAccumulator linear_accumulator_;
@@ -0,0 +1,91 @@
+// Copyright 2021 Faiz Pangestu
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Maintainer : Faiz Pangestu
+ */
+
+#ifndef ACK_6WD_CONTROLLER__ODOMETRY_REPLAY_HPP_
+#define ACK_6WD_CONTROLLER__ODOMETRY_REPLAY_HPP_
+
+#include <vector>
+
+#include "ack_6wd_controller/joint_state_log.hpp"
+#include "rclcpp/time.hpp"
+
+namespace ack_6wd_controller
+{
+// Fused wheel state of one control cycle, as passed to Odometry::updateVel
+struct OdometrySample
+{
+  rclcpp::Time stamp;
+  double angle;     // [rad]
+  double velocity;  // [rad/s]
+};
+
+struct Pose2D
+{
+  double x = 0.0;        //   [m]
+  double y = 0.0;        //   [m]
+  double heading = 0.0;  // [rad]
+};
+
+/**
+ * \brief Pose b expressed in the frame of pose a, composed into the frame a is expressed in
+ */
+Pose2D compose(const Pose2D & a, const Pose2D & b);
+
+/**
+ * \brief Fuse a joint state log into odometry samples the way the controller does
+ *
+ * The log joints must be ordered left wheels, right wheels, left steerings, right steerings,
+ * wheels_per_side of each. Rows with an invalid state are dropped.
+ */
+std::vector<OdometrySample> fuse_joint_state_log(
+  const JointStateLog & log, size_t wheels_per_side, double velocity_scale);
+
+/**
+ * \brief Offline reconstruction of the controller odometry
+ *
+ * The samples are split into segments integrated concurrently with their own Odometry,
+ * starting from the origin, and stitched afterwards. The integration is invariant to the
+ * starting pose, so the result matches a sequential run.
+ */
+class OdometryReplay
+{
+public:
+  OdometryReplay(
+    double wheel_separation, double wheel_base, double left_wheel_radius,
+    double right_wheel_radius);
+
+  /**
+   * \brief Integrate the samples
+   * \param [in] samples      Fused samples, ordered by stamp
+   * \param [in] segment_size Number of samples per segment
+   * \param [in] thread_count Number of worker threads
+   * \return Pose after each sample
+   */
+  std::vector<Pose2D> run(
+    const std::vector<OdometrySample> & samples, size_t segment_size, size_t thread_count) const;
+
+private:
+  double wheel_separation_;
+  double wheel_base_;
+  double left_wheel_radius_;
+  double right_wheel_radius_;
+};
+
+}  // namespace ack_6wd_controller
+
+#endif  // ACK_6WD_CONTROLLER__ODOMETRY_REPLAY_HPP_
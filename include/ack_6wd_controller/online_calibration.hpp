@@ -0,0 +1,114 @@
+// Copyright 2021 Faiz Pangestu
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Maintainer : Faiz Pangestu
+ */
+
+#ifndef ACK_6WD_CONTROLLER__ONLINE_CALIBRATION_HPP_
+#define ACK_6WD_CONTROLLER__ONLINE_CALIBRATION_HPP_
+
+#include <cstddef>
+
+namespace ack_6wd_controller
+{
+/**
+ * \brief Recursive least squares fit of a single gain y = theta * x with exponential forgetting
+ *
+ * Constant time and memory per sample.
+ */
+class ScalarRecursiveLeastSquares
+{
+public:
+  /**
+   * \param [in] forgetting_factor  Weight of the past samples, in (0, 1]
+   * \param [in] initial_covariance Confidence in the initial estimate, larger is weaker
+   */
+  explicit ScalarRecursiveLeastSquares(
+    double forgetting_factor = 0.999, double initial_covariance = 1000.0);
+
+  void reset(double initial_estimate);
+  void update(double x, double y);
+
+  double getEstimate() const { return estimate_; }
+  size_t getSampleCount() const { return sample_count_; }
+
+private:
+  double forgetting_factor_;
+  double initial_covariance_;
+  double estimate_;
+  double covariance_;
+  size_t sample_count_;
+};
+
+/**
+ * \brief Online estimation of the wheel geometry corrections against an external reference
+ *
+ * Three gains are fitted while driving:
+ *  - straight driving, reference speed against odometry speed: effective wheel radius
+ *  - turning, reference yaw rate against the yaw rate the commanded curvature gives at the
+ *    current speed: steering_angle_correction
+ *  - turning, reference speed against commanded speed: angular_velocity_compensation
+ *
+ * The speed fits need a reference speed (localization), the yaw fit works with an IMU alone.
+ */
+class OnlineCalibration
+{
+public:
+  struct Suggestion
+  {
+    double wheel_radius;
+    double steering_angle_correction;
+    double angular_velocity_compensation;
+  };
+
+  explicit OnlineCalibration(
+    double forgetting_factor = 0.999, double min_linear_velocity = 0.1,
+    double min_angular_velocity = 0.05);
+
+  void reset();
+
+  /**
+   * \brief Feed one reference sample
+   * \param [in] command_linear     Commanded linear velocity [m/s]
+   * \param [in] command_angular    Commanded angular velocity [rad/s]
+   * \param [in] odometry_linear    Wheel odometry linear velocity [m/s]
+   * \param [in] odometry_angular   Wheel odometry angular velocity [rad/s]
+   * \param [in] reference_linear   Reference linear velocity [m/s], ignored if !has_linear
+   * \param [in] reference_angular  Reference angular velocity [rad/s]
+   * \param [in] has_linear         Whether the reference provides a linear velocity
+   */
+  void update(
+    double command_linear, double command_angular, double odometry_linear,
+    double odometry_angular, double reference_linear, double reference_angular, bool has_linear);
+
+  /**
+   * \brief Parameters suggested from the current ones, unchanged until enough samples
+   */
+  Suggestion suggest(
+    double wheel_radius, double steering_angle_correction,
+    double angular_velocity_compensation) const;
+
+private:
+  double min_linear_velocity_;
+  double min_angular_velocity_;
+
+  ScalarRecursiveLeastSquares radius_gain_;
+  ScalarRecursiveLeastSquares curvature_gain_;
+  ScalarRecursiveLeastSquares turn_speed_gain_;
+};
+
+}  // namespace ack_6wd_controller
+
+#endif  // ACK_6WD_CONTROLLER__ONLINE_CALIBRATION_HPP_
@@ -0,0 +1,65 @@
+// Copyright 2021 Faiz Pangestu
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Maintainer : Faiz Pangestu
+ */
+
+#ifndef ACK_6WD_CONTROLLER__PARALLEL_FOR_HPP_
+#define ACK_6WD_CONTROLLER__PARALLEL_FOR_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace ack_6wd_controller
+{
+/**
+ * \brief Run work(index) for every index in [0, count) on up to thread_count threads
+ *
+ * Indices are handed out one at a time, so the work items may have uneven cost.
+ * Meant for the offline tools, never call it from the control loop.
+ */
+template <typename Work>
+void parallel_for(size_t count, size_t thread_count, const Work & work)
+{
+  thread_count = std::max<size_t>(1, std::min(thread_count, count));
+
+  std::atomic<size_t> next_index{0};
+  const auto worker = [&]() {
+    for (size_t index = next_index++; index < count; index = next_index++)
+    {
+      work(index);
+    }
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(thread_count - 1);
+  for (size_t i = 1; i < thread_count; ++i)
+  {
+    threads.emplace_back(worker);
+  }
+  worker();
+
+  for (auto & thread : threads)
+  {
+    thread.join();
+  }
+}
+
+}  // namespace ack_6wd_controller
+
+#endif  // ACK_6WD_CONTROLLER__PARALLEL_FOR_HPP_
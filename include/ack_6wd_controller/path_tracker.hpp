@@ -0,0 +1,102 @@
+// Copyright 2021 Faiz Pangestu
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Maintainer : Faiz Pangestu
+ */
+
+#ifndef ACK_6WD_CONTROLLER__PATH_TRACKER_HPP_
+#define ACK_6WD_CONTROLLER__PATH_TRACKER_HPP_
+
+#include <cstddef>
+#include <vector>
+
+namespace ack_6wd_controller
+{
+struct PathPoint
+{
+  double x;  // [m] in the odometry frame
+  double y;  // [m]
+};
+
+/**
+ * \brief Path as handed to the tracker, filled outside the control loop
+ */
+struct TrackedPath
+{
+  std::vector<PathPoint> points;
+  std::vector<double> arc_lengths;  // [m] from the first point, one per point
+
+  // Replaces the points, false when they do not fit into the reserved capacity
+  bool assign(const std::vector<PathPoint> & path_points);
+};
+
+/**
+ * \brief Pure pursuit on a path given in the frame of the odometry
+ *
+ * Steers towards the point one lookahead distance ahead on the path, the lookahead growing with
+ * the speed. The progress along the path only moves forward, so a path crossing itself is
+ * followed in order, and every cycle looks at a bounded window of points. Drives forward only.
+ */
+class PurePursuit
+{
+public:
+  struct Params
+  {
+    double speed = 0.5;                  // [m/s] cruise speed
+    double min_lookahead = 0.5;          // [m]
+    double max_lookahead = 3.0;          // [m]
+    double lookahead_time = 1.0;         // [s] lookahead per speed
+    double goal_tolerance = 0.1;         // [m]
+    double approach_deceleration = 0.5;  // [m/s^2] towards the goal, 0 to stop without slowing
+  };
+
+  enum Status
+  {
+    NO_PATH,
+    TRACKING,
+    GOAL_REACHED,  // commands zero once, then NO_PATH
+  };
+
+  void configure(const Params & params);
+
+  /**
+   * \brief Start tracking a path, from its beginning
+   * \param [in] path Path to track, must stay valid until the next setPath() or clear()
+   */
+  void setPath(const TrackedPath & path);
+
+  void clear();
+
+  /**
+   * \brief Velocity command for the current pose
+   * \param [in] x [m] position of the odometry
+   * \param [in] y [m]
+   * \param [in] heading [rad]
+   * \param [in] speed [m/s] current linear velocity, sets the lookahead distance
+   * \param [out] linear [m/s] linear velocity command
+   * \param [out] angular [rad/s] angular velocity command
+   */
+  Status compute(
+    double x, double y, double heading, double speed, double & linear, double & angular);
+
+private:
+  Params params_;
+  const TrackedPath * path_ = nullptr;
+  size_t progress_ = 0;
+};
+
+}  // namespace ack_6wd_controller
+
+#endif  // ACK_6WD_CONTROLLER__PATH_TRACKER_HPP_
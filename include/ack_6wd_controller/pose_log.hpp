@@ -0,0 +1,52 @@
+// Copyright 2021 Faiz Pangestu
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Maintainer : Faiz Pangestu
+ */
+
+#ifndef ACK_6WD_CONTROLLER__POSE_LOG_HPP_
+#define ACK_6WD_CONTROLLER__POSE_LOG_HPP_
+
+#include <string>
+#include <vector>
+
+#include "ack_6wd_controller/odometry_replay.hpp"
+#include "rclcpp/time.hpp"
+
+namespace ack_6wd_controller
+{
+// Recorded planar poses, e.g. ground truth from motion capture or localization
+struct PoseLog
+{
+  std::vector<rclcpp::Time> stamps;
+  std::vector<Pose2D> poses;
+
+  size_t size() const { return stamps.size(); }
+};
+
+/**
+ * \brief Read the nav_msgs/Odometry poses of a rosbag2 recording
+ * \param [in]  uri   Bag directory
+ * \param [in]  topic Pose topic
+ * \param [out] log   Extracted poses
+ * \param [out] error Reason of the failure
+ * \return false if the bag could not be read
+ */
+bool read_pose_log(
+  const std::string & uri, const std::string & topic, PoseLog & log, std::string & error);
+
+}  // namespace ack_6wd_controller
+
+#endif  // ACK_6WD_CONTROLLER__POSE_LOG_HPP_
@@ -0,0 +1,111 @@
+// Copyright 2021 Faiz Pangestu
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Maintainer : Faiz Pangestu
+ */
+
+#ifndef ACK_6WD_CONTROLLER__SEQLOCK_HPP_
+#define ACK_6WD_CONTROLLER__SEQLOCK_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace ack_6wd_controller
+{
+/**
+ * \brief Latest value shared by one writer with any number of readers, without locks
+ *
+ * The writer never waits. read() retries while a write is in progress, which never ends when
+ * the writer was preempted by the reader, so realtime readers use tryRead(). T must be
+ * trivially copyable.
+ */
+template <typename T>
+class Seqlock
+{
+  static_assert(std::is_trivially_copyable<T>::value, "Seqlock needs a trivially copyable type");
+
+public:
+  Seqlock() : value_() {}
+
+  explicit Seqlock(const T & value) : value_(value) {}
+
+  // Single writer
+  void write(const T & value)
+  {
+    const uint32_t sequence = sequence_.load(std::memory_order_relaxed);
+    // odd while the value is being written
+    sequence_.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(&value_, &value, sizeof(T));
+    std::atomic_thread_fence(std::memory_order_release);
+    sequence_.store(sequence + 2, std::memory_order_relaxed);
+  }
+
+  // Copy of the latest value, returns its sequence number
+  uint32_t read(T & value) const
+  {
+    while (true)
+    {
+      const uint32_t before = sequence_.load(std::memory_order_acquire);
+      if ((before & 1u) != 0)
+      {
+        continue;
+      }
+      std::memcpy(&value, &value_, sizeof(T));
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (sequence_.load(std::memory_order_relaxed) == before)
+      {
+        return before;
+      }
+    }
+  }
+
+  // Copy of the latest value unless a few attempts raced a write, value is untouched then
+  bool tryRead(T & value) const
+  {
+    T copy;
+    for (int attempt = 0; attempt < READ_ATTEMPTS; ++attempt)
+    {
+      const uint32_t before = sequence_.load(std::memory_order_acquire);
+      if ((before & 1u) != 0)
+      {
+        continue;
+      }
+      std::memcpy(&copy, &value_, sizeof(T));
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (sequence_.load(std::memory_order_relaxed) == before)
+      {
+        value = copy;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Sequence number of the latest value, changes with every write
+  uint32_t sequence() const { return sequence_.load(std::memory_order_acquire); }
+
+private:
+  static constexpr int READ_ATTEMPTS = 4;
+
+  std::atomic<uint32_t> sequence_{0};
+  T value_;
+};
+
+}  // namespace ack_6wd_controller
+
+#endif  // ACK_6WD_CONTROLLER__SEQLOCK_HPP_
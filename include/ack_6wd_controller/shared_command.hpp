@@ -0,0 +1,91 @@
+// Copyright 2021 Faiz Pangestu
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Maintainer : Faiz Pangestu
+ */
+
+
+#ifndef ACK_6WD_CONTROLLER__SHARED_COMMAND_HPP_
+#define ACK_6WD_CONTROLLER__SHARED_COMMAND_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "ack_6wd_controller/command_mux.hpp"
+
+namespace ack_6wd_controller
+{
+static_assert(ATOMIC_INT_LOCK_FREE == 2, "The shared command segment needs lock-free atomics");
+
+/**
+ * \brief Layout of the POSIX shared memory segment of a command channel
+ *
+ * The sequence is odd while the producer writes the command. A stamp of 0 asks the
+ * controller to stamp the command with the time it reads it.
+ */
+struct SharedCommandSegment
+{
+  uint32_t magic;
+  uint32_t version;
+  std::atomic<uint32_t> sequence;
+  uint32_t reserved;
+  int64_t stamp_ns;  // [ns] in the clock of the controller
+  double linear;     // [m/s]
+  double angular;    // [rad/s]
+};
+
+/**
+ * \brief Velocity commands passed between processes of one machine through shared memory
+ *
+ * One producer writes the segment as a seqlock, the controller polls it every cycle. Either
+ * side may come up first, the segment is created by whichever opens it first. Reading never
+ * blocks: a read racing a write is retried a few times, then left for the next cycle.
+ */
+class SharedCommandChannel
+{
+public:
+  SharedCommandChannel() = default;
+  SharedCommandChannel(const SharedCommandChannel &) = delete;
+  SharedCommandChannel & operator=(const SharedCommandChannel &) = delete;
+  ~SharedCommandChannel();
+
+  /**
+   * \brief Map the segment, creating it if needed
+   * \param [in]  name  Name of the segment, e.g. "/ack_6wd_controller_cmd_vel"
+   * \param [out] error Why the segment could not be mapped
+   */
+  bool open(const std::string & name, std::string & error);
+  void close();
+  bool isOpen() const { return segment_ != nullptr; }
+
+  // Producer side, one producer per segment
+  void write(const MuxCommand & command);
+
+  /**
+   * \brief Consumer side, the command written since the last call, if any
+   * \param [out] command Written command, left alone when false is returned
+   * \return false when nothing new was written or a write is still in progress
+   */
+  bool read(MuxCommand & command);
+
+private:
+  SharedCommandSegment * segment_ = nullptr;
+  uint32_t last_sequence_ = 0;
+};
+
+}  // namespace ack_6wd_controller
+
+#endif  // ACK_6WD_CONTROLLER__SHARED_COMMAND_HPP_
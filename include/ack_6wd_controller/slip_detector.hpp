@@ -0,0 +1,85 @@
+// Copyright 2021 Faiz Pangestu
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Maintainer : Faiz Pangestu
+ */
+
+#ifndef ACK_6WD_CONTROLLER__SLIP_DETECTOR_HPP_
+#define ACK_6WD_CONTROLLER__SLIP_DETECTOR_HPP_
+
+#include <cstdint>
+#include <vector>
+
+namespace ack_6wd_controller
+{
+/**
+ * \brief Per-cycle consistency check of the drive wheel speeds
+ *
+ * Every wheel speed is scaled back to the speed of the inner steered wheels with the
+ * inverse kinematics ratios of the current turn. The median of these is the consensus, a wheel
+ * disagreeing with it by more than the tolerance is flagged as slipping and its velocity is
+ * replaced by the one the consensus implies, so it no longer weighs on the odometry.
+ *
+ * Wheels are handled as one flat array: left wheels, right wheels, then the middle wheels
+ * (middle right first, as commanded by the controller). Buffers are allocated at configure.
+ */
+class SlipDetector
+{
+public:
+  /**
+   * \param [in] wheels_per_side    Steered wheels per side
+   * \param [in] relative_tolerance Allowed deviation from the consensus, fraction of it
+   * \param [in] absolute_tolerance Allowed deviation from the consensus [m/s]
+   */
+  void configure(size_t wheels_per_side, double relative_tolerance, double absolute_tolerance);
+
+  /**
+   * \brief Check the wheels and correct the velocities of the slipping ones in place
+   * \param [in]      angle               Fused steering angle [rad], > 0 when turning left
+   * \param [in]      wheel_base          Wheel base [m]
+   * \param [in]      wheel_separation    Wheel separation [m]
+   * \param [in]      left_wheel_radius   Left wheel radius [m]
+   * \param [in]      right_wheel_radius  Right wheel radius [m]
+   * \param [in, out] left_velocities     Left wheel velocities [rad/s]
+   * \param [in, out] right_velocities    Right wheel velocities [rad/s]
+   * \param [in, out] middle_velocities   Middle wheel velocities [rad/s], right then left
+   * \return Number of slipping wheels
+   */
+  size_t update(
+    double angle, double wheel_base, double wheel_separation, double left_wheel_radius,
+    double right_wheel_radius, double * left_velocities, double * right_velocities,
+    double * middle_velocities);
+
+  // Bit i set when wheel i of the flat array slipped in the last update
+  uint32_t getSlipMask() const { return slip_mask_; }
+
+private:
+  size_t wheels_per_side_ = 0;
+  double relative_tolerance_ = 0.0;
+  double absolute_tolerance_ = 0.0;
+
+  std::vector<double> speeds_;   // encoder rate of each wheel [rad/s]
+  std::vector<double> radii_;    // radius of each wheel [m]
+  std::vector<double> ratios_;   // expected speed relative to the inner steered wheels
+  std::vector<double> implied_;  // inner steered wheel speed implied by each wheel [m/s]
+  std::vector<double> valid_;    // 1.0 for consistent wheels, 0.0 for slipping ones
+  std::vector<double> scratch_;
+
+  uint32_t slip_mask_ = 0;
+};
+
+}  // namespace ack_6wd_controller
+
+#endif  // ACK_6WD_CONTROLLER__SLIP_DETECTOR_HPP_
@@ -0,0 +1,104 @@
+// Copyright 2021 Faiz Pangestu
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Maintainer : Faiz Pangestu
+ */
+
+#ifndef ACK_6WD_CONTROLLER__SPSC_QUEUE_HPP_
+#define ACK_6WD_CONTROLLER__SPSC_QUEUE_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace ack_6wd_controller
+{
+/**
+ * \brief Bounded lock-free queue between one producer and one consumer thread
+ *
+ * Storage is allocated by the constructor, push() and pop() only copy elements, so either side
+ * can be a realtime thread. The capacity is rounded up to a power of two.
+ */
+template <typename T>
+class SpscQueue
+{
+public:
+  explicit SpscQueue(size_t capacity = 1)
+  {
+    size_t size = 2;
+    while (size < capacity + 1)
+    {
+      size *= 2;
+    }
+    slots_.resize(size);
+    mask_ = size - 1;
+  }
+
+  SpscQueue(const SpscQueue &) = delete;
+  SpscQueue & operator=(const SpscQueue &) = delete;
+
+  size_t capacity() const { return mask_; }
+
+  // Producer side, false when the queue is full
+  bool push(const T & value)
+  {
+    const size_t tail = tail_.value.load(std::memory_order_relaxed);
+    const size_t next = (tail + 1) & mask_;
+    if (next == head_.value.load(std::memory_order_acquire))
+    {
+      return false;
+    }
+    slots_[tail] = value;
+    tail_.value.store(next, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side, false when the queue is empty
+  bool pop(T & value)
+  {
+    const size_t head = head_.value.load(std::memory_order_relaxed);
+    if (head == tail_.value.load(std::memory_order_acquire))
+    {
+      return false;
+    }
+    value = slots_[head];
+    head_.value.store((head + 1) & mask_, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side
+  bool empty() const
+  {
+    return head_.value.load(std::memory_order_relaxed) ==
+           tail_.value.load(std::memory_order_acquire);
+  }
+
+private:
+  std::vector<T> slots_;
+  size_t mask_ = 0;
+
+  // kept on separate cache lines, each is written by one side only
+  struct PaddedIndex
+  {
+    std::atomic<size_t> value{0};
+    char padding[64 - sizeof(std::atomic<size_t>)];
+  };
+  PaddedIndex head_;
+  PaddedIndex tail_;
+};
+
+}  // namespace ack_6wd_controller
+
+#endif  // ACK_6WD_CONTROLLER__SPSC_QUEUE_HPP_
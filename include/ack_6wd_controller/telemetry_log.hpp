@@ -0,0 +1,153 @@
+// Copyright 2021 Faiz Pangestu
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Maintainer : Faiz Pangestu
+ */
+
+#ifndef ACK_6WD_CONTROLLER__TELEMETRY_LOG_HPP_
+#define ACK_6WD_CONTROLLER__TELEMETRY_LOG_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ack_6wd_controller/spsc_queue.hpp"
+
+namespace ack_6wd_controller
+{
+// Columns a telemetry sample has room for, the stamp not included
+constexpr size_t TELEMETRY_MAX_COLUMNS = 64;
+
+/**
+ * \brief Column of a telemetry log
+ *
+ * Values are stored as multiples of the step, so the step is the resolution kept.
+ */
+struct TelemetryColumn
+{
+  std::string name;
+  double step;
+};
+
+// One row of a telemetry log, fixed size so it can be queued from the control loop
+struct TelemetrySample
+{
+  int64_t stamp_ns;
+  double values[TELEMETRY_MAX_COLUMNS];
+};
+
+/*
+ * File layout, all integers little endian:
+ *
+ *   header  "ACKTLM\0\0", u32 version, u32 column count,
+ *           per column: u32 name length, name, f64 step
+ *   chunks  u32 "CHNK", u32 row count, u32 column count + 1,
+ *           u64 encoded size of the stamps and of every column, then the encoded data
+ *
+ * In a chunk the stamps are stored as delta of delta, the quantized values as delta, both
+ * zigzag varint encoded. Steady rates and slowly changing values take one byte per row, and
+ * a reader skips the columns it does not need using the sizes in the chunk header.
+ */
+
+/**
+ * \brief Writer of a telemetry log, encoding on its own thread
+ *
+ * push() only copies the sample to a preallocated queue and can be called from the control
+ * loop, samples are dropped when the queue is full.
+ */
+class TelemetryWriter
+{
+public:
+  TelemetryWriter() = default;
+  ~TelemetryWriter();
+
+  TelemetryWriter(const TelemetryWriter &) = delete;
+  TelemetryWriter & operator=(const TelemetryWriter &) = delete;
+
+  /**
+   * \brief Create the log and start the writer thread
+   * \param [in]  path       Log file, truncated
+   * \param [in]  columns    Columns, at most TELEMETRY_MAX_COLUMNS
+   * \param [in]  chunk_rows Rows per chunk
+   * \param [in]  queue_size Samples buffered between the control loop and the writer thread
+   * \param [out] error      Reason of a failure
+   */
+  bool open(
+    const std::string & path, const std::vector<TelemetryColumn> & columns, size_t chunk_rows,
+    size_t queue_size, std::string & error);
+
+  // Write the buffered samples and stop the writer thread
+  void close();
+
+  bool isOpen() const { return thread_.joinable(); }
+
+  // Queue a sample, false if it was dropped
+  bool push(const TelemetrySample & sample);
+
+  uint64_t getDroppedCount() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+  void run();
+  void flush();
+
+  std::ofstream file_;
+  std::vector<TelemetryColumn> columns_;
+  size_t chunk_rows_ = 0;
+
+  std::unique_ptr<SpscQueue<TelemetrySample>> queue_;
+  std::thread thread_;
+  std::atomic<bool> running_{false};
+  std::atomic<uint64_t> dropped_{0};
+
+  // rows of the chunk being filled, owned by the writer thread
+  std::vector<int64_t> stamps_;
+  std::vector<std::vector<int64_t>> quantized_;
+  std::vector<std::vector<uint8_t>> encoded_;
+};
+
+/**
+ * \brief Reader of a telemetry log, decoding only the requested column
+ */
+class TelemetryReader
+{
+public:
+  bool open(const std::string & path, std::string & error);
+
+  const std::vector<TelemetryColumn> & columns() const { return columns_; }
+
+  // Index of the column, columns().size() if there is none with this name
+  size_t find(const std::string & name) const;
+
+  bool read_stamps(std::vector<int64_t> & stamps, std::string & error);
+  bool read_column(size_t column, std::vector<double> & values, std::string & error);
+
+private:
+  // slot 0 is the stamps, slot column + 1 a column
+  bool read_slot(size_t slot, std::vector<int64_t> & values, std::string & error);
+
+  std::string path_;
+  std::ifstream file_;
+  std::streamoff data_offset_ = 0;
+  std::streamoff file_size_ = 0;
+  std::vector<TelemetryColumn> columns_;
+};
+
+}  // namespace ack_6wd_controller
+
+#endif  // ACK_6WD_CONTROLLER__TELEMETRY_LOG_HPP_
@@ -0,0 +1,99 @@
+// Copyright 2021 Faiz Pangestu
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Maintainer : Faiz Pangestu
+ */
+
+#ifndef ACK_6WD_CONTROLLER__THREAD_PRIORITY_HPP_
+#define ACK_6WD_CONTROLLER__THREAD_PRIORITY_HPP_
+
+#include <sched.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ack_6wd_controller
+{
+// ThreadSchedule::policy keeping the policy and priority the thread has
+constexpr int THREAD_POLICY_KEEP = -1;
+
+/**
+ * \brief Scheduling of a thread
+ *
+ * An empty affinity keeps the CPUs the thread has.
+ */
+struct ThreadSchedule
+{
+  int policy = THREAD_POLICY_KEEP;  // SCHED_* policy
+  int priority = 0;                 // 1 to 99 for SCHED_FIFO and SCHED_RR, 0 otherwise
+  std::vector<int> cpu_affinity;    // CPUs the thread may run on
+};
+
+/**
+ * \brief Build a schedule from its parameters
+ * \param [in]  policy       "fifo", "rr", "other", "batch", "idle", or "" to keep the policy
+ * \param [in]  priority     Priority, in the range of the policy
+ * \param [in]  cpu_affinity CPUs, empty to keep the affinity
+ * \param [out] schedule     Parsed schedule
+ * \param [out] error        Reason of a failure
+ */
+bool parse_thread_schedule(
+  const std::string & policy, int64_t priority, const std::vector<int64_t> & cpu_affinity,
+  ThreadSchedule & schedule, std::string & error);
+
+/**
+ * \brief Apply a schedule to the calling thread
+ * \param [in]  schedule Schedule to apply
+ * \param [out] error    Reason of a failure, usually missing privileges
+ * \return false if part of the schedule could not be applied
+ */
+bool apply_thread_schedule(const ThreadSchedule & schedule, std::string & error);
+
+/**
+ * \brief Apply a schedule to the calling thread for the lifetime of the guard
+ *
+ * Threads inherit the scheduling and affinity of the thread creating them. Threads started by
+ * other libraries, like the one of realtime_tools::RealtimePublisher, are scheduled by creating
+ * them while the guard is alive. The previous scheduling is restored by restore() or the
+ * destructor.
+ */
+class ScopedThreadSchedule
+{
+public:
+  explicit ScopedThreadSchedule(const ThreadSchedule & schedule);
+  ~ScopedThreadSchedule();
+
+  ScopedThreadSchedule(const ScopedThreadSchedule &) = delete;
+  ScopedThreadSchedule & operator=(const ScopedThreadSchedule &) = delete;
+
+  // Whether the schedule was applied, error() tells why not
+  bool ok() const { return error_.empty(); }
+  const std::string & error() const { return error_; }
+
+  // Restore the previous scheduling, false if it could not be
+  bool restore();
+
+private:
+  bool active_ = false;
+  int previous_policy_ = SCHED_OTHER;
+  sched_param previous_param_;
+  cpu_set_t previous_cpus_;
+  std::string error_;
+};
+
+}  // namespace ack_6wd_controller
+
+#endif  // ACK_6WD_CONTROLLER__THREAD_PRIORITY_HPP_
@@ -0,0 +1,89 @@
+// Copyright 2021 Faiz Pangestu
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Maintainer : Faiz Pangestu
+ */
+
+
+#ifndef ACK_6WD_CONTROLLER__TICK_ACCUMULATOR_HPP_
+#define ACK_6WD_CONTROLLER__TICK_ACCUMULATOR_HPP_
+
+#include <cmath>
+#include <cstdint>
+
+namespace ack_6wd_controller
+{
+/**
+ * \brief Travel of an encoder counted in integer ticks, across wrap-arounds of its counter
+ *
+ * Counting in int64 keeps the travel exact however long the robot drives, where a double
+ * position would lose the resolution of a tick after enough revolutions.
+ */
+class TickAccumulator
+{
+public:
+  /**
+   * \param [in] wrap_ticks Range of the encoder counter, 0 when it does not wrap. A step of more
+   *  than half of it between two readings is taken as a wrap-around.
+   */
+  explicit TickAccumulator(int64_t wrap_ticks = 0) : wrap_ticks_(wrap_ticks) {}
+
+  void reset()
+  {
+    previous_ = 0;
+    ticks_ = 0;
+    initialized_ = false;
+  }
+
+  // Accumulate a reading of the counter [ticks], returns the travel since reset [ticks]
+  int64_t accumulate(double position)
+  {
+    const int64_t current = std::llround(position);
+    if (!initialized_)
+    {
+      previous_ = current;
+      initialized_ = true;
+      return ticks_;
+    }
+
+    int64_t delta = current - previous_;
+    if (wrap_ticks_ > 0)
+    {
+      delta %= wrap_ticks_;
+      if (delta > wrap_ticks_ / 2)
+      {
+        delta -= wrap_ticks_;
+      }
+      else if (delta < -wrap_ticks_ / 2)
+      {
+        delta += wrap_ticks_;
+      }
+    }
+    previous_ = current;
+    ticks_ += delta;
+    return ticks_;
+  }
+
+  int64_t getTicks() const { return ticks_; }
+
+private:
+  int64_t wrap_ticks_;
+  int64_t previous_ = 0;
+  int64_t ticks_ = 0;
+  bool initialized_ = false;
+};
+}  // namespace ack_6wd_controller
+
+#endif  // ACK_6WD_CONTROLLER__TICK_ACCUMULATOR_HPP_
@@ -0,0 +1,84 @@
+// Copyright 2021 Faiz Pangestu
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Maintainer : Faiz Pangestu
+ */
+
+#ifndef ACK_6WD_CONTROLLER__TRACKING_MONITOR_HPP_
+#define ACK_6WD_CONTROLLER__TRACKING_MONITOR_HPP_
+
+#include <cstddef>
+#include <vector>
+
+namespace ack_6wd_controller
+{
+/**
+ * \brief Running comparison of the commanded and measured joint values
+ *
+ * Every cycle the commands written in the previous cycle are compared against the states read
+ * in this one. For each joint a smoothed mean square error is kept for every delay from 0 to
+ * max_lag cycles: the delay with the smallest error is the lag estimate, the error at that delay
+ * tells how well the joint follows once the lag is accounted for, and the error at delay 0 is
+ * the tracking error seen by the controller. Memory is fixed at configure.
+ */
+class TrackingMonitor
+{
+public:
+  /**
+   * \param [in] joint_count Number of monitored joints
+   * \param [in] max_lag     Largest lag estimated [cycles]
+   * \param [in] smoothing   Weight of the newest sample in the running averages, in (0, 1]
+   */
+  void configure(size_t joint_count, size_t max_lag, double smoothing);
+
+  // Forget the command history and the averages, e.g. after the commands were interrupted
+  void reset();
+
+  /**
+   * \brief Feed one cycle
+   * \param [in] commands Values written to the joints in the previous cycle, joint_count entries
+   * \param [in] states   Values measured this cycle, joint_count entries
+   * \param [in] period   Time since the previous cycle [s]
+   */
+  void update(const double * commands, const double * states, double period);
+
+  size_t getJointCount() const { return joint_count_; }
+
+  // RMS error between the measured values and the previous commands
+  double getRmsError(size_t joint) const;
+  // RMS error once delayed by the estimated lag
+  double getLaggedRmsError(size_t joint) const;
+  // Estimated lag [cycles]
+  size_t getLag(size_t joint) const { return lags_[joint]; }
+  // Estimated lag [s]
+  double getLagTime(size_t joint) const { return lags_[joint] * period_; }
+
+private:
+  size_t joint_count_ = 0;
+  size_t history_size_ = 0;  // max_lag + 1
+  double smoothing_ = 1.0;
+
+  std::vector<double> history_;        // commands, history_size_ per joint, ring
+  std::vector<double> mean_squares_;   // smoothed squared error, history_size_ per joint
+  std::vector<size_t> lags_;
+  size_t head_ = 0;                    // slot of the newest command
+  size_t filled_ = 0;                  // commands in the history
+  size_t sample_count_ = 0;
+  double period_ = 0.0;                // smoothed cycle period [s]
+};
+
+}  // namespace ack_6wd_controller
+
+#endif  // ACK_6WD_CONTROLLER__TRACKING_MONITOR_HPP_
@@ -0,0 +1,91 @@
+// Copyright 2021 Faiz Pangestu
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Maintainer : Faiz Pangestu
+ */
+
+#ifndef ACK_6WD_CONTROLLER__TRIPLE_BUFFER_HPP_
+#define ACK_6WD_CONTROLLER__TRIPLE_BUFFER_HPP_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace ack_6wd_controller
+{
+/**
+ * \brief Latest value passed from one writer to one reader thread, without locks or copies
+ *
+ * The writer fills its own buffer and publishes it, the reader swaps in the latest published
+ * buffer and keeps it until its next update. Neither side waits, so T may be large and own
+ * storage allocated up front, e.g. a vector with reserved capacity.
+ */
+template <typename T>
+class TripleBuffer
+{
+public:
+  TripleBuffer() = default;
+
+  TripleBuffer(const TripleBuffer &) = delete;
+  TripleBuffer & operator=(const TripleBuffer &) = delete;
+
+  // Calls init on all three buffers and drops anything published, while neither side runs
+  template <typename F>
+  void initialize(F init)
+  {
+    for (auto & buffer : buffers_)
+    {
+      init(buffer);
+    }
+    write_ = 0;
+    state_.store(1, std::memory_order_relaxed);
+    read_ = 2;
+  }
+
+  // Writer side, the buffer to fill before publish()
+  T & writeBuffer() { return buffers_[write_]; }
+
+  void publish()
+  {
+    write_ = state_.exchange(write_ | FRESH, std::memory_order_acq_rel) & INDEX;
+  }
+
+  // Reader side, true when a newer buffer was swapped in
+  bool update()
+  {
+    if ((state_.load(std::memory_order_relaxed) & FRESH) == 0)
+    {
+      return false;
+    }
+    read_ = state_.exchange(read_, std::memory_order_acq_rel) & INDEX;
+    return true;
+  }
+
+  const T & readBuffer() const { return buffers_[read_]; }
+
+private:
+  static constexpr uint8_t INDEX = 0x3;
+  static constexpr uint8_t FRESH = 0x4;
+
+  std::array<T, 3> buffers_;
+  uint8_t write_ = 0;
+  // index of the buffer between the two sides, with FRESH set when published and not yet read
+  std::atomic<uint8_t> state_{1};
+  uint8_t read_ = 2;
+};
+
+}  // namespace ack_6wd_controller
+
+#endif  // ACK_6WD_CONTROLLER__TRIPLE_BUFFER_HPP_
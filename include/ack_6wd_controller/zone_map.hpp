@@ -0,0 +1,74 @@
+// Copyright 2021 Faiz Pangestu
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Maintainer : Faiz Pangestu
+ */
+
+#ifndef ACK_6WD_CONTROLLER__ZONE_MAP_HPP_
+#define ACK_6WD_CONTROLLER__ZONE_MAP_HPP_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace ack_6wd_controller
+{
+/**
+ * \brief Speed limits of areas in the odometry frame, looked up in constant time
+ *
+ * Zones are polygons with a maximum speed, read from a text file with one zone per line:
+ *
+ *   # max_speed x1 y1 x2 y2 x3 y3 ...
+ *   0.3  1.0 2.0  4.0 2.0  4.0 5.0  1.0 5.0
+ *
+ * Loading rasterizes them into a grid, a cell taking the lowest limit of the zones it overlaps
+ * or lies within the margin of. The margin leaves room to slow down before a zone. Zones
+ * narrower than a cell are kept, they just grow to the cells they touch.
+ */
+class ZoneMap
+{
+public:
+  /**
+   * \brief Load and rasterize the zones of a file
+   * \param [in] path Zone file
+   * \param [in] resolution [m] Cell size
+   * \param [in] margin [m] Grow every zone by this distance
+   * \param [out] error Reason when false is returned
+   */
+  bool load(const std::string & path, double resolution, double margin, std::string & error);
+
+  void clear();
+
+  size_t getZoneCount() const { return zone_count_; }
+
+  /**
+   * \brief Speed limit at a position
+   * \return [m/s] Maximum speed, infinity outside of all zones
+   */
+  double getSpeedLimit(double x, double y) const;
+
+private:
+  double resolution_ = 1.0;
+  double origin_x_ = 0.0;
+  double origin_y_ = 0.0;
+  size_t width_ = 0;
+  size_t height_ = 0;
+  std::vector<float> cells_;  // row major, infinity for no limit
+  size_t zone_count_ = 0;
+};
+
+}  // namespace ack_6wd_controller
+
+#endif  // ACK_6WD_CONTROLLER__ZONE_MAP_HPP_
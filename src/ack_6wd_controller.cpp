@@ -21,6 +21,9 @@
 #define _USE_MATH_DEFINES
 #include <cmath>
 
+#include <algorithm>
+#include <iterator>
+#include <limits>
 #include <memory>
 #include <queue>
 #include <string>
@@ -28,6 +31,8 @@
 #include <vector>
 
 #include "ack_6wd_controller/ack_6wd_controller.hpp"
+#include "ack_6wd_controller/kinematics.hpp"
+#include "ack_6wd_controller/thread_priority.hpp"
 #include "hardware_interface/types/hardware_interface_type_values.hpp"
 #include "lifecycle_msgs/msg/state.hpp"
 #include "rclcpp/logging.hpp"
@@ -38,8 +43,19 @@ namespace
 constexpr auto DEFAULT_COMMAND_TOPIC = "/cmd_vel";
 constexpr auto DEFAULT_COMMAND_UNSTAMPED_TOPIC = "/cmd_vel";
 constexpr auto DEFAULT_COMMAND_OUT_TOPIC = "~/cmd_vel_out";
+constexpr auto DEFAULT_COMMAND_INPUT = "cmd_vel";
 constexpr auto DEFAULT_ODOMETRY_TOPIC = "/odom";
 constexpr auto DEFAULT_TRANSFORM_TOPIC = "/tf";
+constexpr auto DEFAULT_CALIBRATION_TOPIC = "~/calibration/suggested_parameters";
+constexpr auto DEFAULT_TRACKING_ERROR_TOPIC = "~/tracking_error";
+constexpr auto DEFAULT_FLIGHT_RECORD_SERVICE = "~/dump_flight_record";
+
+// captured records handed to the capture writer per cycle, drains the pre-trigger backlog
+constexpr size_t CAPTURE_RECORDS_PER_CYCLE = 8;
+constexpr size_t CAPTURE_CHUNK_ROWS = 256;
+
+// how often the cmd_vel thread checks whether it should stop
+constexpr auto COMMAND_THREAD_SPIN_TIMEOUT = std::chrono::milliseconds(100);
 }  // namespace
 
 namespace ack_6wd_controller
@@ -53,6 +69,14 @@ using lifecycle_msgs::msg::State;
 
 Ack6WDController::Ack6WDController() : controller_interface::ControllerInterface() {}
 
+constexpr size_t Ack6WDController::MAX_WHEELS_PER_SIDE;
+
+Ack6WDController::~Ack6WDController()
+{
+  stop_estimation_thread();
+  stop_command_thread();
+}
+
 controller_interface::return_type Ack6WDController::init(const std::string & controller_name)
 {
   // initialize lifecycle node
@@ -74,6 +98,8 @@ controller_interface::return_type Ack6WDController::init(const std::string & con
 
     auto_declare<double>("wheel_base", wheel_params_.base);
     auto_declare<double>("wheel_separation", wheel_params_.separation);
+    auto_declare<double>("max_steering_angle", feasible_command_params_.max_steering_angle);
+    auto_declare<std::string>("feasible_command.policy", "preserve_speed");
     auto_declare<int>("wheels_per_side", wheel_params_.wheels_per_side);
     auto_declare<double>("wheel_radius", wheel_params_.radius);
     auto_declare<double>("wheel_base_multiplier", wheel_params_.base_multiplier);
@@ -89,12 +115,46 @@ controller_interface::return_type Ack6WDController::init(const std::string & con
     auto_declare<std::vector<double>>("pose_covariance_diagonal", std::vector<double>());
     auto_declare<std::vector<double>>("twist_covariance_diagonal", std::vector<double>());
     auto_declare<bool>("open_loop", odom_params_.open_loop);
+    auto_declare<std::string>("odometry_mode", "velocity");
+    auto_declare<double>(
+      "position_odometry.ticks_per_revolution", position_odometry_params_.ticks_per_revolution);
+    auto_declare<double>(
+      "position_odometry.ticks_per_position_unit", position_odometry_params_.ticks_per_position_unit);
+    auto_declare<int>("position_odometry.wrap_ticks", position_odometry_params_.wrap_ticks);
     auto_declare<bool>("enable_odom_tf", odom_params_.enable_odom_tf);
 
     auto_declare<double>("cmd_vel_timeout", cmd_vel_timeout_.count() / 1000.0);
     auto_declare<bool>("publish_limited_velocity", publish_limited_velocity_);
     auto_declare<int>("velocity_rolling_window_size", 10);
     auto_declare<bool>("use_stamped_vel", use_stamped_vel_);
+    auto_declare<std::vector<std::string>>("command_inputs", {DEFAULT_COMMAND_INPUT});
+    auto_declare<bool>("command_stamp_check.enable", true);
+    auto_declare<double>("command_stamp_check.tolerance", 0.0);
+    auto_declare<bool>("shared_command.enable", false);
+    auto_declare<std::string>("shared_command.segment", "/ack_6wd_controller_cmd_vel");
+    auto_declare<std::string>("shared_command.input", "shared_memory");
+    auto_declare<bool>("reference_interfaces.enable", false);
+    auto_declare<std::string>("reference_interfaces.input", "reference");
+    auto_declare<bool>("odometry_state_interfaces.enable", false);
+    auto_declare<bool>("path_tracking.enable", path_tracking_params_.enable);
+    auto_declare<std::string>("path_tracking.topic", path_tracking_params_.topic);
+    auto_declare<std::string>("path_tracking.input", path_tracking_params_.input);
+    auto_declare<int>("path_tracking.max_points", path_tracking_params_.max_points);
+    auto_declare<double>("path_tracking.speed", path_tracking_params_.pursuit.speed);
+    auto_declare<double>(
+      "path_tracking.min_lookahead", path_tracking_params_.pursuit.min_lookahead);
+    auto_declare<double>(
+      "path_tracking.max_lookahead", path_tracking_params_.pursuit.max_lookahead);
+    auto_declare<double>(
+      "path_tracking.lookahead_time", path_tracking_params_.pursuit.lookahead_time);
+    auto_declare<double>(
+      "path_tracking.goal_tolerance", path_tracking_params_.pursuit.goal_tolerance);
+    auto_declare<double>(
+      "path_tracking.approach_deceleration", path_tracking_params_.pursuit.approach_deceleration);
+    auto_declare<bool>("command_prediction.enable", command_prediction_params_.enable);
+    auto_declare<int>("command_prediction.order", command_prediction_params_.order);
+    auto_declare<double>("command_prediction.max_gap", command_prediction_params_.max_gap);
+    auto_declare<double>("command_prediction.horizon", command_prediction_params_.horizon);
 
     auto_declare<bool>("linear.x.has_velocity_limits", false);
     auto_declare<bool>("linear.x.has_acceleration_limits", false);
@@ -116,6 +176,87 @@ controller_interface::return_type Ack6WDController::init(const std::string & con
     auto_declare<double>("angular.z.max_jerk", NAN);
     auto_declare<double>("angular.z.min_jerk", NAN);
     auto_declare<double>("publish_rate", publish_rate_);
+
+    auto_declare<bool>("cmd_vel_thread.enable", command_thread_params_.enable);
+    auto_declare<int>("cmd_vel_thread.priority", command_thread_params_.priority);
+    auto_declare<std::vector<int64_t>>("cmd_vel_thread.cpu_affinity", command_thread_params_.cpu_affinity);
+
+    for (const auto & group : {"publishers", "loggers"})
+    {
+      const std::string prefix = std::string("helper_threads.") + group;
+      auto_declare<std::string>(prefix + ".policy", "");
+      auto_declare<int>(prefix + ".priority", 0);
+      auto_declare<std::vector<int64_t>>(prefix + ".cpu_affinity", std::vector<int64_t>());
+    }
+
+    auto_declare<double>("joint_transform.wheel_scale", 1.0 / RPM_TO_RAD_PER_SEC);
+    auto_declare<double>("joint_transform.steering_scale", 1.0);
+    auto_declare<std::vector<double>>("joint_transform.signs", std::vector<double>());
+    auto_declare<std::vector<double>>("joint_transform.offsets", std::vector<double>());
+    auto_declare<std::vector<double>>("joint_transform.lower_limits", std::vector<double>());
+    auto_declare<std::vector<double>>("joint_transform.upper_limits", std::vector<double>());
+
+    auto_declare<bool>("claim_all_state_interfaces", false);
+
+    auto_declare<bool>("estop.enable", estop_params_.enable);
+    auto_declare<std::string>("estop.interface", estop_params_.interface);
+    auto_declare<bool>("estop.active_high", estop_params_.active_high);
+
+    auto_declare<bool>("zone_map.enable", zone_map_params_.enable);
+    auto_declare<std::string>("zone_map.file", zone_map_params_.file);
+    auto_declare<double>("zone_map.resolution", zone_map_params_.resolution);
+    auto_declare<double>("zone_map.margin", zone_map_params_.margin);
+
+    auto_declare<bool>("change_mask.enable", change_mask_params_.enable);
+    auto_declare<std::string>("change_mask.interface", change_mask_params_.interface);
+    auto_declare<double>("change_mask.wheel_deadband", change_mask_params_.wheel_deadband);
+    auto_declare<double>("change_mask.steering_deadband", change_mask_params_.steering_deadband);
+    auto_declare<std::vector<double>>("change_mask.deadbands", std::vector<double>());
+    auto_declare<int>("change_mask.refresh_cycles", change_mask_params_.refresh_cycles);
+
+    auto_declare<bool>("estimation_thread.enable", estimation_thread_params_.enable);
+    auto_declare<int>("estimation_thread.queue_size", estimation_thread_params_.queue_size);
+    auto_declare<std::string>("estimation_thread.policy", "");
+    auto_declare<int>("estimation_thread.priority", 0);
+    auto_declare<std::vector<int64_t>>("estimation_thread.cpu_affinity", std::vector<int64_t>());
+
+    auto_declare<bool>("slip_detection.enable", slip_detection_params_.enable);
+    auto_declare<double>("slip_detection.relative_tolerance", slip_detection_params_.relative_tolerance);
+    auto_declare<double>("slip_detection.absolute_tolerance", slip_detection_params_.absolute_tolerance);
+
+    auto_declare<bool>("tracking_monitor.enable", tracking_monitor_params_.enable);
+    auto_declare<int>("tracking_monitor.max_lag", tracking_monitor_params_.max_lag);
+    auto_declare<double>("tracking_monitor.smoothing", tracking_monitor_params_.smoothing);
+    auto_declare<double>("tracking_monitor.wheel_error_threshold", tracking_monitor_params_.wheel_error_threshold);
+    auto_declare<double>("tracking_monitor.steering_error_threshold", tracking_monitor_params_.steering_error_threshold);
+
+    auto_declare<bool>("flight_recorder.enable", flight_recorder_params_.enable);
+    auto_declare<std::string>("flight_recorder.path", flight_recorder_params_.path);
+    auto_declare<int>("flight_recorder.capacity", flight_recorder_params_.capacity);
+    auto_declare<double>("flight_recorder.deadline", flight_recorder_params_.deadline);
+
+    auto_declare<bool>("telemetry.enable", telemetry_params_.enable);
+    auto_declare<std::string>("telemetry.path", telemetry_params_.path);
+    auto_declare<int>("telemetry.chunk_rows", telemetry_params_.chunk_rows);
+    auto_declare<int>("telemetry.queue_size", telemetry_params_.queue_size);
+    auto_declare<double>("telemetry.velocity_step", telemetry_params_.velocity_step);
+    auto_declare<double>("telemetry.position_step", telemetry_params_.position_step);
+    auto_declare<double>("telemetry.time_step", telemetry_params_.time_step);
+
+    auto_declare<bool>("capture.enable", capture_params_.enable);
+    auto_declare<std::string>("capture.path", capture_params_.path);
+    auto_declare<std::vector<std::string>>("capture.triggers", capture_params_.triggers);
+    auto_declare<int>("capture.pre_trigger_cycles", capture_params_.pre_trigger_cycles);
+    auto_declare<int>("capture.post_trigger_cycles", capture_params_.post_trigger_cycles);
+    auto_declare<double>("capture.deadline", capture_params_.deadline);
+    auto_declare<int>("capture.queue_size", capture_params_.queue_size);
+
+    auto_declare<bool>("calibration.enable", calibration_params_.enable);
+    auto_declare<std::string>("calibration.reference", calibration_params_.reference);
+    auto_declare<std::string>("calibration.reference_topic", calibration_params_.reference_topic);
+    auto_declare<double>("calibration.forgetting_factor", calibration_params_.forgetting_factor);
+    auto_declare<double>("calibration.min_linear_velocity", calibration_params_.min_linear_velocity);
+    auto_declare<double>("calibration.min_angular_velocity", calibration_params_.min_angular_velocity);
   }
   catch (const std::exception & e)
   {
@@ -149,41 +290,206 @@ InterfaceConfiguration Ack6WDController::command_interface_configuration() const
   {
     conf_names.push_back(joint_name + "/" + HW_IF_POSITION);
   }
+  if (change_mask_params_.enable)
+  {
+    conf_names.push_back(change_mask_params_.interface);
+  }
   return {interface_configuration_type::INDIVIDUAL, conf_names};
 }
 
 InterfaceConfiguration Ack6WDController::state_interface_configuration() const
 {
+  // only what the odometry mode and the enabled features read, see configure_claimed_states()
   std::vector<std::string> conf_names;
-  for (const auto & joint_name : left_wheel_names_)
+  const auto claim = [&conf_names](
+                       const std::vector<std::string> & joint_names, bool position, bool velocity) {
+    for (const auto & joint_name : joint_names)
+    {
+      if (position)
+      {
+        conf_names.push_back(joint_name + "/" + HW_IF_POSITION);
+      }
+      if (velocity)
+      {
+        conf_names.push_back(joint_name + "/" + HW_IF_VELOCITY);
+      }
+    }
+  };
+  claim(left_wheel_names_, claimed_states_.wheel_position, claimed_states_.wheel_velocity);
+  claim(right_wheel_names_, claimed_states_.wheel_position, claimed_states_.wheel_velocity);
+  claim(
+    middle_wheel_names_, claimed_states_.middle_wheel_position,
+    claimed_states_.middle_wheel_velocity);
+  claim(left_steering_names_, claimed_states_.steering_position, claimed_states_.steering_velocity);
+  claim(right_steering_names_, claimed_states_.steering_position, claimed_states_.steering_velocity);
+  if (estop_params_.enable)
   {
-    conf_names.push_back(joint_name + "/" + HW_IF_POSITION);        
-    conf_names.push_back(joint_name + "/" + HW_IF_VELOCITY);
+    conf_names.push_back(estop_params_.interface);
   }
-  for (const auto & joint_name : right_wheel_names_)
+  return {interface_configuration_type::INDIVIDUAL, conf_names};
+}
+
+controller_interface::return_type Ack6WDController::update()
+{
+  if (
+    (!flight_recorder_params_.enable && !telemetry_params_.enable && !capture_params_.enable) ||
+    get_current_state().id() == State::PRIMARY_STATE_INACTIVE)
   {
-    conf_names.push_back(joint_name + "/" + HW_IF_POSITION);
-    conf_names.push_back(joint_name + "/" + HW_IF_VELOCITY);
+    return update_cycle();
   }
-  for (const auto & joint_name : middle_wheel_names_)
+
+  const auto start = std::chrono::steady_clock::now();
+  flight_recorder_.begin();
+  const auto result = update_cycle();
+  const double execution_time =
+    std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  const bool failed = result != controller_interface::return_type::OK;
+  const bool overran = flight_recorder_params_.deadline > 0.0 &&
+                       execution_time > flight_recorder_params_.deadline;
+  const bool capture_overran =
+    capture_params_.deadline > 0.0 && execution_time > capture_params_.deadline;
+
+  auto & record = flight_recorder_.current();
+  record.execution_time = execution_time;
+  record.result = static_cast<int32_t>(result);
+  if (failed)
   {
-    conf_names.push_back(joint_name + "/" + HW_IF_POSITION);
-    conf_names.push_back(joint_name + "/" + HW_IF_VELOCITY);
+    record.events |= EVENT_ERROR;
   }
-  for (const auto & joint_name : left_steering_names_)
+  if (overran || capture_overran)
   {
-    conf_names.push_back(joint_name + "/" + HW_IF_POSITION);
-    conf_names.push_back(joint_name + "/" + HW_IF_VELOCITY);
+    record.events |= EVENT_OVERRUN;
   }
-  for (const auto & joint_name : right_steering_names_)
+  record_flight_state(record);
+  flight_recorder_.commit();
+
+  if (telemetry_params_.enable)
   {
-    conf_names.push_back(joint_name + "/" + HW_IF_POSITION);
-    conf_names.push_back(joint_name + "/" + HW_IF_VELOCITY);
+    fill_telemetry_sample(record, telemetry_sample_);
+    if (!telemetry_writer_.push(telemetry_sample_))
+    {
+      RCLCPP_WARN_THROTTLE(
+        node_->get_logger(), *node_->get_clock(), 1000,
+        "Telemetry writer is falling behind, %lu samples dropped so far",
+        static_cast<unsigned long>(telemetry_writer_.getDroppedCount()));
+    }
   }
-  return {interface_configuration_type::INDIVIDUAL, conf_names};
+
+  if (capture_params_.enable)
+  {
+    capture_window_.push(record, (record.events & capture_trigger_mask_) != 0);
+    for (size_t index = 0; index < CAPTURE_RECORDS_PER_CYCLE; ++index)
+    {
+      const FlightRecord * captured = capture_window_.pop();
+      if (captured == nullptr)
+      {
+        break;
+      }
+      fill_telemetry_sample(*captured, capture_sample_);
+      if (!capture_writer_.push(capture_sample_))
+      {
+        RCLCPP_WARN_THROTTLE(
+          node_->get_logger(), *node_->get_clock(), 1000,
+          "Capture writer is falling behind, %lu samples dropped so far",
+          static_cast<unsigned long>(capture_writer_.getDroppedCount()));
+      }
+    }
+  }
+
+  // dump once when a failure or an overrun starts, the ring then holds what led to it
+  if (failed && !flight_recorder_failed_)
+  {
+    flight_recorder_.dump(FlightRecorder::DUMP_ON_ERROR, record.stamp_ns);
+  }
+  else if (overran && !flight_recorder_overran_)
+  {
+    flight_recorder_.dump(FlightRecorder::DUMP_ON_DEADLINE_MISS, record.stamp_ns);
+  }
+  else if (flight_record_requested_.exchange(false))
+  {
+    flight_recorder_.dump(FlightRecorder::DUMP_ON_REQUEST, record.stamp_ns);
+  }
+  flight_recorder_failed_ = failed;
+  flight_recorder_overran_ = overran;
+
+  return result;
 }
 
-controller_interface::return_type Ack6WDController::update()
+void Ack6WDController::record_flight_state(FlightRecord & record) const
+{
+  // NaN for the interfaces that are not claimed
+  const auto read_state =
+    [&record](const hardware_interface::LoanedStateInterface * interface) -> double {
+      if (interface == nullptr)
+      {
+        return std::numeric_limits<double>::quiet_NaN();
+      }
+      const double value = interface->get_value();
+      if (std::isnan(value))
+      {
+        record.events |= EVENT_INVALID_STATE;
+      }
+      return value;
+    };
+
+  size_t joint = 0;
+  const auto record_wheels = [&record, &joint, &read_state](const std::vector<WheelHandle> & handles) {
+    for (const auto & handle : handles)
+    {
+      record.joint_positions[joint] = read_state(handle.encoder_position);
+      record.joint_velocities[joint] = read_state(handle.encoder_velocity);
+      record.joint_commands[joint] = handle.velocity.get().get_value();
+      ++joint;
+    }
+  };
+  const auto record_steerings = [&record, &joint, &read_state](
+                                  const std::vector<SteeringHandle> & handles) {
+    for (const auto & handle : handles)
+    {
+      record.joint_positions[joint] = read_state(handle.encoder_position);
+      record.joint_velocities[joint] = read_state(handle.encoder_velocity);
+      record.joint_commands[joint] = handle.position.get().get_value();
+      ++joint;
+    }
+  };
+  record_wheels(registered_left_wheel_handles_);
+  record_wheels(registered_right_wheel_handles_);
+  record_wheels(registered_middle_wheel_handles_);
+  record_steerings(registered_left_steering_handles_);
+  record_steerings(registered_right_steering_handles_);
+  record.joint_count = static_cast<uint32_t>(joint);
+
+  record.odometry_x = odometry_estimate_.x;
+  record.odometry_y = odometry_estimate_.y;
+  record.odometry_heading = odometry_estimate_.heading;
+  record.odometry_linear = odometry_estimate_.linear;
+  record.odometry_angular = odometry_estimate_.angular;
+}
+
+void Ack6WDController::fill_telemetry_sample(
+  const FlightRecord & record, TelemetrySample & sample) const
+{
+  // same column order as telemetry_columns()
+  sample.stamp_ns = record.stamp_ns;
+  size_t column = 0;
+  for (const double value :
+       {record.period, record.execution_time, static_cast<double>(record.events),
+        record.command_linear, record.command_angular, record.limited_linear,
+        record.limited_angular, record.odometry_x, record.odometry_y, record.odometry_heading,
+        record.odometry_linear, record.odometry_angular})
+  {
+    sample.values[column++] = value;
+  }
+  for (size_t joint = 0; joint < record.joint_count; ++joint)
+  {
+    sample.values[column++] = record.joint_positions[joint];
+    sample.values[column++] = record.joint_velocities[joint];
+    sample.values[column++] = record.joint_commands[joint];
+  }
+}
+
+controller_interface::return_type Ack6WDController::update_cycle()
 {
   auto logger = node_->get_logger();
   
@@ -194,34 +500,137 @@ controller_interface::return_type Ack6WDController::update()
       halt();
       is_halted = true;
     }
+    discard_path();
     return controller_interface::return_type::OK;
   }
 
   const auto current_time = node_->get_clock()->now();
 
-  std::shared_ptr<Twist> last_msg;
-  received_velocity_msg_ptr_.get(last_msg);
+  auto & record = flight_recorder_.current();
+  record.stamp_ns = current_time.nanoseconds();
+  record.period = (current_time - previous_update_timestamp_).seconds();
 
-  if (last_msg == nullptr)
+  // read before anything else, the hardware may already be stopping
+  if (estop_interface_ != nullptr)
   {
-    RCLCPP_WARN(logger, "Velocity message received was a nullptr.");
-    return controller_interface::return_type::ERROR;
+    const double value = estop_interface_->get_value();
+    const bool engaged = std::isnan(value) || ((value > 0.5) == estop_params_.active_high);
+    if (engaged != estop_engaged_)
+    {
+      if (engaged)
+      {
+        RCLCPP_WARN(logger, "E-stop engaged, stopping");
+      }
+      else
+      {
+        RCLCPP_INFO(logger, "E-stop released");
+      }
+      estop_engaged_ = engaged;
+    }
+    if (engaged)
+    {
+      // stop first, the cycle goes on for the odometry and skips the command path below
+      record.events |= EVENT_ESTOP;
+      halt();
+    }
+  }
+
+  if (tracking_monitor_params_.enable)
+  {
+    update_tracking_monitor((current_time - previous_update_timestamp_).seconds());
   }
 
-  const auto dt = current_time - last_msg->header.stamp;
-  // Brake if cmd_vel has timeout, override the stored command
-  if (dt > cmd_vel_timeout_)
+  // commands of a co-located producer, polled rather than delivered by an executor
+  MuxCommand shared_command;
+  if (shared_command_channel_.isOpen() && shared_command_channel_.read(shared_command))
   {
-    last_msg->twist.linear.x = 0.0;
-    last_msg->twist.angular.z = 0.0;
+    if (shared_command.stamp_ns == 0)
+    {
+      shared_command.stamp_ns = current_time.nanoseconds();
+    }
+    offer_command(shared_command_input_, shared_command);
+  }
+
+  // references written by controllers of this loop, consumed so that a stopped writer times out
+  if (linear_velocity_reference_)
+  {
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    MuxCommand reference_command;
+    reference_command.stamp_ns = current_time.nanoseconds();
+    reference_command.linear = linear_velocity_reference_->exchange(nan);
+    reference_command.angular = angular_velocity_reference_->exchange(nan);
+    if (std::isfinite(reference_command.linear) && std::isfinite(reference_command.angular))
+    {
+      offer_command(reference_input_, reference_command);
+    }
+  }
+
+  // pure pursuit against the odometry of the previous cycle
+  if (path_tracking_params_.enable)
+  {
+    if (!discard_path() && path_buffer_.update())
+    {
+      pure_pursuit_.setPath(path_buffer_.readBuffer());
+    }
+    MuxCommand path_command;
+    path_command.stamp_ns = current_time.nanoseconds();
+    const auto status = pure_pursuit_.compute(
+      odometry_estimate_.x, odometry_estimate_.y, odometry_estimate_.heading,
+      odometry_estimate_.linear, path_command.linear, path_command.angular);
+    if (status != PurePursuit::NO_PATH)
+    {
+      offer_command(path_input_, path_command);
+    }
+  }
+
+  // freshest command of the input with the highest priority, brake when all have timed out
+  MuxCommand selected_command;
+  const size_t selected_input = command_mux_.select(current_time.nanoseconds(), selected_command);
+  if (selected_input == command_mux_.size())
+  {
+    record.events |= EVENT_COMMAND_TIMEOUT;
+  }
+  if (selected_input != selected_command_input_)
+  {
+    if (selected_input == command_mux_.size())
+    {
+      RCLCPP_INFO(logger, "All command inputs timed out, stopping");
+    }
+    else
+    {
+      RCLCPP_INFO(
+        logger, "Following command input %s", command_mux_.getInput(selected_input).name.c_str());
+    }
+    selected_command_input_ = selected_input;
+    command_predictor_.reset();
   }
 
-  // command may be limited further by SpeedLimit,
-  // without affecting the stored twist command
-  Twist command = *last_msg;
+  // between the messages of the input, smoother than holding the last one
+  if (command_prediction_params_.enable && selected_input != command_mux_.size())
+  {
+    command_predictor_.add(
+      selected_command.stamp_ns, selected_command.linear, selected_command.angular);
+    command_predictor_.predict(
+      current_time.nanoseconds(), selected_command.linear, selected_command.angular);
+  }
+  record.command_linear = selected_command.linear;
+  record.command_angular = selected_command.angular;
+
+  // command may be limited further by SpeedLimit
+  Twist command;
+  command.header.stamp = rclcpp::Time(selected_command.stamp_ns);
+  command.twist.linear.x = selected_command.linear;
+  command.twist.angular.z = selected_command.angular;
   double & linear_command = command.twist.linear.x;
   double & angular_command = command.twist.angular.z;
 
+  // nothing is commanded during an e-stop, the odometry below still follows the wheels
+  if (estop_engaged_)
+  {
+    linear_command = 0.0;
+    angular_command = 0.0;
+  }
+
   // Apply (possibly new) multipliers:
   const auto wheels = wheel_params_;
   const double wheel_base = wheels.base_multiplier * wheels.base;
@@ -231,54 +640,64 @@ controller_interface::return_type Ack6WDController::update()
   const double ang_vel_comp = wheels.angular_velocity_compensation;
   const double steering_correction = wheels.steering_angle_correction;
 
-  // Speed limiter
-  if (angular_command != 0 && linear_command == 0){
-    RCLCPP_ERROR(logger, "Turning radius is too short!\n");
-    return controller_interface::return_type::ERROR;
+  // turns tighter than the steering allows, turning on the spot included, are projected
+  // onto the nearest feasible command instead of being refused
+  const double steering_limit = std::min(
+    feasible_command_params_.max_steering_angle / std::abs(steering_correction), M_PI / 2);
+  const double min_turning_radius =
+    minimum_turning_radius(wheel_base, wheel_separation, steering_limit);
+  const bool turn_on_the_spot = linear_command == 0.0 && angular_command != 0.0;
+  if (project_feasible_command(
+        min_turning_radius, feasible_command_params_.policy, linear_command, angular_command))
+  {
+    record.events |= EVENT_LIMITER_SATURATION;
+    if (turn_on_the_spot && feasible_command_params_.policy == PRESERVE_SPEED)
+    {
+      RCLCPP_WARN_ONCE(
+        logger,
+        "Stopping instead of turning on the spot, which the steering cannot do. Use "
+        "feasible_command.policy preserve_curvature to drive the tightest turn instead, "
+        "this message will only be shown once");
+    }
   }
 
   if (odom_params_.open_loop)
   {
     odometry_.updateOpenLoop(linear_command, angular_command, current_time);
+    odometry_estimate_.x = odometry_.getX();
+    odometry_estimate_.y = odometry_.getY();
+    odometry_estimate_.heading = odometry_.getHeading();
+    odometry_estimate_.linear = odometry_.getLinear();
+    odometry_estimate_.angular = odometry_.getAngular();
   }
   else
   {
-    // double left_position_mean = 0.0;
-    // double right_position_mean = 0.0;
-    // for (size_t index = 0; index < wheels.wheels_per_side; ++index)
-    // {
-    //   const double left_position = registered_left_wheel_handles_[index].position.get().get_value();
-    //   const double right_position =
-    //     registered_right_wheel_handles_[index].position.get().get_value();
-
-    //   if (std::isnan(left_position) || std::isnan(right_position))
-    //   {
-    //     RCLCPP_ERROR(
-    //       logger, "Either the left or right wheel position is invalid for index [%zu]", index);
-    //     return controller_interface::return_type::ERROR;
-    //   }
-
-    //   left_position_mean += left_position;
-    //   right_position_mean += right_position;
-    // }
-
-    double left_velocity_mean = 0.0;
-    double right_velocity_mean = 0.0;
-    double left_angle_mean = 0.0;
-    double right_angle_mean = 0.0;
-    int q = 0;
-    for (size_t index = 0; index < wheels.wheels_per_side; ++index)
+    // wheel velocities and steering angles of all joints, back to [rad/s] and [rad]
+    for (size_t joint = 0; joint < joint_state_interfaces_.size(); ++joint)
     {
-      const double left_velocity = registered_left_wheel_handles_[index].velocity.get().get_value() * 2 * 3.14 / 60; // to rad/s
-      const double right_velocity = registered_right_wheel_handles_[index].velocity.get().get_value() * 2 * 3.14 / 60;
-      const double left_angle = registered_left_steering_handles_[index].position.get().get_value();
-      const double right_angle = registered_right_steering_handles_[index].position.get().get_value();
+      // middle wheels are only claimed for the features using them
+      const auto interface = joint_state_interfaces_[joint];
+      joint_states_[joint] =
+        interface != nullptr ? interface->get_value() : std::numeric_limits<double>::quiet_NaN();
+    }
+    joint_transforms_.invert(joint_states_.data(), joint_states_.data());
 
-      if (index == 0){
-        q = quadrant(left_velocity, left_angle);
-      }
+    const double * left_velocities = joint_states_.data();
+    const double * right_velocities = left_velocities + left_wheel_names_.size();
+    const double * middle_velocities = right_velocities + right_wheel_names_.size();
+    const double * left_angles = middle_velocities + middle_wheel_names_.size();
+    const double * right_angles = left_angles + left_steering_names_.size();
+
+    // snapshot of the wheel states, estimated from here on
+    EstimationInput & input = estimation_input_;
+    for (size_t index = 0; index < wheels.wheels_per_side; ++index)
+    {
+      const double left_velocity = left_velocities[index];
+      const double right_velocity = right_velocities[index];
+      const double left_angle = left_angles[index];
+      const double right_angle = right_angles[index];
 
-      if (std::isnan(left_velocity) || std::isnan(right_velocity))
+      if (claimed_states_.wheel_velocity && (std::isnan(left_velocity) || std::isnan(right_velocity)))
       {
         RCLCPP_ERROR(
           logger, "Either the left or right wheel velocity is invalid for index [%zu]", index);
@@ -292,35 +711,96 @@ controller_interface::return_type Ack6WDController::update()
         return controller_interface::return_type::ERROR;
       }
 
-      left_velocity_mean += abs(left_velocity);
-      right_velocity_mean += abs(right_velocity);
-
-      left_angle_mean += abs(left_angle);
-      right_angle_mean += abs(right_angle);
+      input.left_wheel_velocities[index] = left_velocity;
+      input.right_wheel_velocities[index] = right_velocity;
+      input.left_steering_angles[index] = left_angle;
+      input.right_steering_angles[index] = right_angle;
     }
 
-    left_velocity_mean = left_velocity_mean/wheels.wheels_per_side;
-    right_velocity_mean = right_velocity_mean/wheels.wheels_per_side;
-    left_angle_mean = left_angle_mean/wheels.wheels_per_side;
-    right_angle_mean = right_angle_mean/wheels.wheels_per_side;
+    if (slip_detection_params_.enable)
+    {
+      // middle wheels only take part in the consistency check
+      for (size_t index = 0; index < middle_wheel_names_.size(); ++index)
+      {
+        const double middle_velocity = middle_velocities[index];
+        if (std::isnan(middle_velocity))
+        {
+          RCLCPP_ERROR(logger, "The middle wheel velocity is invalid for index [%zu]", index);
+          return controller_interface::return_type::ERROR;
+        }
+        input.middle_wheel_velocities[index] = middle_velocity;
+      }
+    }
 
-    double velocity_encoder = std::min(std::abs(left_velocity_mean), std::abs(right_velocity_mean)) * (q == 0 || q == 1 ? 1 : -1);
-    double angle_encoder = std::max(std::abs(left_angle_mean), std::abs(right_angle_mean)) * (q == 0 || q == 2 ? 1 : -1);
+    if (odom_params_.use_positions)
+    {
+      // encoder counts, accumulated by the odometry
+      const auto read_positions = [&logger](const std::vector<WheelHandle> & handles, double * positions) {
+        for (size_t index = 0; index < handles.size(); ++index)
+        {
+          positions[index] = handles[index].encoder_position->get_value();
+          if (std::isnan(positions[index]))
+          {
+            RCLCPP_ERROR(logger, "The wheel position is invalid for index [%zu]", index);
+            return false;
+          }
+        }
+        return true;
+      };
+      if (!read_positions(registered_left_wheel_handles_, input.left_wheel_positions) ||
+          !read_positions(registered_right_wheel_handles_, input.right_wheel_positions) ||
+          !read_positions(registered_middle_wheel_handles_, input.middle_wheel_positions))
+      {
+        return controller_interface::return_type::ERROR;
+      }
+    }
 
-    // Debug mean
-    // RCLCPP_INFO(logger, "Velocity: %f, Angle: %f",  velocity_encoder, angle_encoder);
+    input.stamp = current_time;
+    input.wheel_base = wheel_base;
+    input.wheel_separation = wheel_separation;
+    input.left_wheel_radius = left_wheel_radius;
+    input.right_wheel_radius = right_wheel_radius;
+    input.wheel_radius = wheels.radius;
+    input.steering_angle_correction = steering_correction;
+    input.angular_velocity_compensation = ang_vel_comp;
 
-    // odometry_.update(left_position_mean, right_position_mean, current_time);
-    // RCLCPP_INFO(logger, "Velocity: %f, Angle: %f",  velocity_encoder, angle_encoder);
-    odometry_.updateVel(angle_encoder, velocity_encoder, current_time);
+    // the command the wheels were driving with
+    input.command_linear = previous_commands_.back().twist.linear.x;
+    input.command_angular = previous_commands_.back().twist.angular.z;
 
-    // Debug odom
-    RCLCPP_INFO(logger, "DEBUG: %f", steering_correction);
+    if (estimation_thread_params_.enable)
+    {
+      if (estimation_queue_->push(input))
+      {
+        // never blocks, wakes the estimation thread
+        sem_post(&estimation_semaphore_);
+      }
+      else
+      {
+        RCLCPP_WARN_THROTTLE(
+          logger, *node_->get_clock(), 1000, "Estimation thread is falling behind, dropping states");
+      }
+      // the latest estimate, usually of the previous cycle, the one before while it is written
+      estimation_output_.tryRead(odometry_estimate_);
+    }
+    else
+    {
+      estimate(input, odometry_estimate_);
+    }
+  }
 
+  // at the full control rate, for controllers later in this loop
+  if (odometry_state_interfaces_.x)
+  {
+    odometry_state_interfaces_.x->set(odometry_estimate_.x);
+    odometry_state_interfaces_.y->set(odometry_estimate_.y);
+    odometry_state_interfaces_.heading->set(odometry_estimate_.heading);
+    odometry_state_interfaces_.linear_velocity->set(odometry_estimate_.linear);
+    odometry_state_interfaces_.angular_velocity->set(odometry_estimate_.angular);
   }
 
   tf2::Quaternion orientation;
-  orientation.setRPY(0.0, 0.0, odometry_.getHeading());
+  orientation.setRPY(0.0, 0.0, odometry_estimate_.heading);
 
   if (previous_publish_timestamp_ + publish_period_ < current_time)
   {
@@ -330,14 +810,14 @@ controller_interface::return_type Ack6WDController::update()
     {
       auto & odometry_message = realtime_odometry_publisher_->msg_;
       odometry_message.header.stamp = current_time;
-      odometry_message.pose.pose.position.x = odometry_.getX();
-      odometry_message.pose.pose.position.y = odometry_.getY();
+      odometry_message.pose.pose.position.x = odometry_estimate_.x;
+      odometry_message.pose.pose.position.y = odometry_estimate_.y;
       odometry_message.pose.pose.orientation.x = orientation.x();
       odometry_message.pose.pose.orientation.y = orientation.y();
       odometry_message.pose.pose.orientation.z = orientation.z();
       odometry_message.pose.pose.orientation.w = orientation.w();
-      odometry_message.twist.twist.linear.x = odometry_.getLinear();
-      odometry_message.twist.twist.angular.z = odometry_.getAngular();
+      odometry_message.twist.twist.linear.x = odometry_estimate_.linear;
+      odometry_message.twist.twist.angular.z = odometry_estimate_.angular;
       realtime_odometry_publisher_->unlockAndPublish();
     }
 
@@ -345,25 +825,85 @@ controller_interface::return_type Ack6WDController::update()
     {
       auto & transform = realtime_odometry_transform_publisher_->msg_.transforms.front();
       transform.header.stamp = current_time;
-      transform.transform.translation.x = odometry_.getX();
-      transform.transform.translation.y = odometry_.getY();
+      transform.transform.translation.x = odometry_estimate_.x;
+      transform.transform.translation.y = odometry_estimate_.y;
       transform.transform.rotation.x = orientation.x();
       transform.transform.rotation.y = orientation.y();
       transform.transform.rotation.z = orientation.z();
       transform.transform.rotation.w = orientation.w();
       realtime_odometry_transform_publisher_->unlockAndPublish();
     }
+
+    if (calibration_params_.enable && realtime_calibration_publisher_->trylock())
+    {
+      auto & calibration_message = realtime_calibration_publisher_->msg_;
+      calibration_message.data[0] = odometry_estimate_.suggested_wheel_radius;
+      calibration_message.data[1] = odometry_estimate_.suggested_steering_angle_correction;
+      calibration_message.data[2] = odometry_estimate_.suggested_angular_velocity_compensation;
+      realtime_calibration_publisher_->unlockAndPublish();
+    }
+
+    if (tracking_monitor_params_.enable && realtime_tracking_error_publisher_->trylock())
+    {
+      auto & tracking_message = realtime_tracking_error_publisher_->msg_;
+      const size_t joint_count = tracking_monitor_.getJointCount();
+      for (size_t joint = 0; joint < joint_count; ++joint)
+      {
+        tracking_message.data[joint] = tracking_monitor_.getRmsError(joint);
+        tracking_message.data[joint_count + joint] = tracking_monitor_.getLaggedRmsError(joint);
+        tracking_message.data[2 * joint_count + joint] = tracking_monitor_.getLagTime(joint);
+      }
+      realtime_tracking_error_publisher_->unlockAndPublish();
+    }
+  }
+
+  if (estop_engaged_)
+  {
+    // the limiter ramps up from standstill once released, not from the speed before the stop
+    previous_commands_.front() = Twist();
+    previous_commands_.back() = Twist();
+    previous_update_timestamp_ = current_time;
+    command_predictor_.reset();
+    return controller_interface::return_type::OK;
   }
 
   const auto update_dt = current_time - previous_update_timestamp_;
   previous_update_timestamp_ = current_time;
 
+  // slow zones around the pose, the limiters below shape the slow down
+  if (zone_map_params_.enable)
+  {
+    const double zone_limit =
+      zone_map_.getSpeedLimit(odometry_estimate_.x, odometry_estimate_.y);
+    if (std::fabs(linear_command) > zone_limit)
+    {
+      // the same curvature at the lower speed
+      const double scale = zone_limit / std::fabs(linear_command);
+      linear_command *= scale;
+      angular_command *= scale;
+      record.events |= EVENT_LIMITER_SATURATION;
+    }
+  }
+
   auto & last_command = previous_commands_.back().twist;
   auto & second_to_last_command = previous_commands_.front().twist;
-  limiter_linear_.limit(
+  const double linear_factor = limiter_linear_.limit(
     linear_command, last_command.linear.x, second_to_last_command.linear.x, update_dt.seconds());
-  limiter_angular_.limit(
+  const double angular_factor = limiter_angular_.limit(
     angular_command, last_command.angular.z, second_to_last_command.angular.z, update_dt.seconds());
+  if (linear_factor != 1.0 || angular_factor != 1.0)
+  {
+    record.events |= EVENT_LIMITER_SATURATION;
+  }
+
+  // the limiters act on each axis alone, take back any curvature they tightened
+  if (project_feasible_command(
+        min_turning_radius, PRESERVE_SPEED, linear_command, angular_command))
+  {
+    record.events |= EVENT_LIMITER_SATURATION;
+  }
+  record.limited_linear = linear_command;
+  record.limited_angular = angular_command;
 
   previous_commands_.pop();
   previous_commands_.emplace(command);
@@ -388,8 +928,8 @@ controller_interface::return_type Ack6WDController::update()
 
     angle_left = 0;
     angle_right = 0;
-  } else if (linear_command != 0) {
-    // Turning radius
+  } else {
+    // Turning radius, at least the minimum after the projection above
     turning_radius = abs(linear_command / angular_command);
 
     // Compute steering angles: (pi = M_PI = 3.14........)
@@ -406,9 +946,6 @@ controller_interface::return_type Ack6WDController::update()
 
     velocity_mid_left = abs(angular_command * (turning_radius - wheel_base) / left_wheel_radius) * ang_vel_comp;
     velocity_mid_right = abs(angular_command * (turning_radius + wheel_base) / right_wheel_radius) * ang_vel_comp;
-  } else {
-    RCLCPP_ERROR(logger, "Turning radius is too short!\n");
-    return controller_interface::return_type::ERROR;
   }
 
   // Direction matrix
@@ -433,32 +970,32 @@ controller_interface::return_type Ack6WDController::update()
   const double wheel_velocity_mid_left = d[q][2] * (q == 0 || q == 3 ? velocity_mid_left : velocity_mid_right);
   const double wheel_velocity_mid_right = d[q][3] * (q == 0 || q == 3 ? velocity_mid_right : velocity_mid_left);
 
-  // Debugger
-  // RCLCPP_INFO(logger, "velocity left, front: %f, steering: %f \nvelocity right, front: %f, steering: %f \n", 
-  //             wheel_velocity_left * 60 / 6.283, 
-  //             steering_angle_left, 
-  //             wheel_velocity_right  * 60 / 6.283, 
-  //             steering_angle_right);
-  // RCLCPP_INFO(logger, "mid left %f, right: %f\n", 
-  //             wheel_velocity_mid_left * 60 / 6.283,
-  //             wheel_velocity_mid_right * 60 / 6.283);
-
-  // Set motor state: set value type const double
-  for (size_t index = 0; index < wheels.wheels_per_side; ++index)
+  // Commands of all joints [rad/s] and [rad], the transforms take them to the hardware units
+  size_t joint = 0;
+  for (size_t index = 0; index < left_wheel_names_.size(); ++index)
   {
-    registered_left_wheel_handles_[index].velocity.get().set_value(wheel_velocity_left * 60 / 6.283);  // to rpm
-    registered_right_wheel_handles_[index].velocity.get().set_value(wheel_velocity_right * 60 / 6.283);
+    joint_commands_[joint++] = wheel_velocity_left;
   }
+  for (size_t index = 0; index < right_wheel_names_.size(); ++index)
+  {
+    joint_commands_[joint++] = wheel_velocity_right;
+  }
+  for (size_t index = 0; index < middle_wheel_names_.size(); ++index)
+  {
+    // middle right wheel first
+    joint_commands_[joint++] = index == 0 ? wheel_velocity_mid_right : wheel_velocity_mid_left;
+  }
+  for (size_t index = 0; index < left_steering_names_.size(); ++index)
+  {
+    joint_commands_[joint++] = steering_angle_left;
+  }
+  for (size_t index = 0; index < right_steering_names_.size(); ++index)
+  {
+    joint_commands_[joint++] = steering_angle_right;
+  }
+  write_joint_commands();
 
-  registered_middle_wheel_handles_[0].velocity.get().set_value(wheel_velocity_mid_right * 60 / 6.283); // Middle-right wheel
-  registered_middle_wheel_handles_[1].velocity.get().set_value(wheel_velocity_mid_left * 60 / 6.283);  // Middle-left wheel
-
-  registered_left_steering_handles_[0].position.get().set_value(steering_angle_left);     // Front wheels [rad]
-  registered_right_steering_handles_[0].position.get().set_value(-steering_angle_right);
-
-  registered_left_steering_handles_[1].position.get().set_value(-steering_angle_left);    // Rear wheels
-  registered_right_steering_handles_[1].position.get().set_value(steering_angle_right);
-
+  has_written_commands_ = true;
   return controller_interface::return_type::OK;
 }
 
@@ -552,6 +1089,51 @@ CallbackReturn Ack6WDController::on_configure(const rclcpp_lifecycle::State &)
     twist_diagonal.begin(), twist_diagonal.end(), odom_params_.twist_covariance_diagonal.begin());
 
   odom_params_.open_loop = node_->get_parameter("open_loop").as_bool();
+
+  const auto odometry_mode = node_->get_parameter("odometry_mode").as_string();
+  if (odometry_mode != "velocity" && odometry_mode != "position")
+  {
+    RCLCPP_ERROR(
+      logger, "odometry_mode must be velocity or position, got [%s]", odometry_mode.c_str());
+    return CallbackReturn::ERROR;
+  }
+  odom_params_.use_positions = odometry_mode == "position";
+
+  position_odometry_params_.ticks_per_revolution =
+    node_->get_parameter("position_odometry.ticks_per_revolution").as_double();
+  position_odometry_params_.ticks_per_position_unit =
+    node_->get_parameter("position_odometry.ticks_per_position_unit").as_double();
+  position_odometry_params_.wrap_ticks =
+    node_->get_parameter("position_odometry.wrap_ticks").as_int();
+  if (
+    !(position_odometry_params_.ticks_per_revolution > 0.0) ||
+    !(position_odometry_params_.ticks_per_position_unit >= 0.0) ||
+    position_odometry_params_.wrap_ticks < 0)
+  {
+    RCLCPP_ERROR(
+      logger, "position_odometry needs ticks_per_revolution > 0, ticks_per_position_unit >= 0 "
+      "and wrap_ticks >= 0");
+    return CallbackReturn::ERROR;
+  }
+  // ros2_control position interfaces report radians
+  const char * position_unit = "custom position unit";
+  if (position_odometry_params_.ticks_per_position_unit == 0.0)
+  {
+    position_odometry_params_.ticks_per_position_unit =
+      position_odometry_params_.ticks_per_revolution / (2 * M_PI);
+    position_unit = "positions in radians";
+  }
+  else if (position_odometry_params_.ticks_per_position_unit == 1.0)
+  {
+    position_unit = "positions in ticks";
+  }
+  if (odom_params_.use_positions)
+  {
+    RCLCPP_INFO(
+      logger, "Position odometry with %g ticks per revolution, %g ticks per position unit, %s",
+      position_odometry_params_.ticks_per_revolution,
+      position_odometry_params_.ticks_per_position_unit, position_unit);
+  }
   odom_params_.enable_odom_tf = node_->get_parameter("enable_odom_tf").as_bool();
 
   cmd_vel_timeout_ = std::chrono::milliseconds{
@@ -559,6 +1141,26 @@ CallbackReturn Ack6WDController::on_configure(const rclcpp_lifecycle::State &)
   publish_limited_velocity_ = node_->get_parameter("publish_limited_velocity").as_bool();
   use_stamped_vel_ = node_->get_parameter("use_stamped_vel").as_bool();
 
+  command_thread_params_.enable = node_->get_parameter("cmd_vel_thread.enable").as_bool();
+  command_thread_params_.priority = node_->get_parameter("cmd_vel_thread.priority").as_int();
+  command_thread_params_.cpu_affinity =
+    node_->get_parameter("cmd_vel_thread.cpu_affinity").as_integer_array();
+
+  for (const auto & group : {std::make_pair("publishers", &publisher_thread_schedule_),
+                             std::make_pair("loggers", &logger_thread_schedule_)})
+  {
+    const std::string prefix = std::string("helper_threads.") + group.first;
+    std::string error;
+    if (!parse_thread_schedule(
+          node_->get_parameter(prefix + ".policy").as_string(),
+          node_->get_parameter(prefix + ".priority").as_int(),
+          node_->get_parameter(prefix + ".cpu_affinity").as_integer_array(), *group.second, error))
+    {
+      RCLCPP_ERROR(logger, "Invalid %s: %s", prefix.c_str(), error.c_str());
+      return CallbackReturn::ERROR;
+    }
+  }
+
   try
   {
     limiter_linear_ = SpeedLimiter(
@@ -603,122 +1205,1562 @@ CallbackReturn Ack6WDController::on_configure(const rclcpp_lifecycle::State &)
   // left and right sides are both equal at this point
   wheel_params_.wheels_per_side = left_wheel_names_.size();
 
-  if (publish_limited_velocity_)
+  // wheel states gathered each cycle for the odometry
+  if (wheel_params_.wheels_per_side > MAX_WHEELS_PER_SIDE || middle_wheel_names_.size() > 2)
   {
-    limited_velocity_publisher_ =
-      node_->create_publisher<Twist>(DEFAULT_COMMAND_OUT_TOPIC, rclcpp::SystemDefaultsQoS());
-    realtime_limited_velocity_publisher_ =
-      std::make_shared<realtime_tools::RealtimePublisher<Twist>>(limited_velocity_publisher_);
+    RCLCPP_ERROR(
+      logger, "At most %zu wheels per side and 2 middle wheels are supported", MAX_WHEELS_PER_SIDE);
+    return CallbackReturn::ERROR;
+  }
+  estimation_input_ = EstimationInput();
+
+  // travel of every drive wheel, in the order of the joint transforms
+  const size_t wheel_count =
+    left_wheel_names_.size() + right_wheel_names_.size() + middle_wheel_names_.size();
+  wheel_ticks_.assign(wheel_count, TickAccumulator(position_odometry_params_.wrap_ticks));
+  integrated_ticks_.assign(wheel_count, 0);
+
+  slip_detection_params_.enable = node_->get_parameter("slip_detection.enable").as_bool();
+  slip_detection_params_.relative_tolerance =
+    node_->get_parameter("slip_detection.relative_tolerance").as_double();
+  slip_detection_params_.absolute_tolerance =
+    node_->get_parameter("slip_detection.absolute_tolerance").as_double();
+  if (slip_detection_params_.enable && middle_wheel_names_.size() != 2)
+  {
+    RCLCPP_ERROR(
+      logger, "Slip detection needs exactly 2 middle wheels, got [%zu]", middle_wheel_names_.size());
+    return CallbackReturn::ERROR;
+  }
+  slip_detector_.configure(
+    wheel_params_.wheels_per_side, slip_detection_params_.relative_tolerance,
+    slip_detection_params_.absolute_tolerance);
+
+  if (configure_joint_transforms() == CallbackReturn::ERROR)
+  {
+    return CallbackReturn::ERROR;
+  }
+
+  if (configure_command_mux() == CallbackReturn::ERROR)
+  {
+    return CallbackReturn::ERROR;
+  }
+
+  // left over from a configuration that failed half way
+  unexport_interfaces();
+  if (
+    configure_reference_interfaces() == CallbackReturn::ERROR ||
+    configure_odometry_state_interfaces() == CallbackReturn::ERROR ||
+    configure_path_tracking() == CallbackReturn::ERROR ||
+    configure_estop() == CallbackReturn::ERROR ||
+    configure_zone_map() == CallbackReturn::ERROR ||
+    configure_feasible_command() == CallbackReturn::ERROR)
+  {
+    return CallbackReturn::ERROR;
   }
 
   const Twist empty_twist;
-  received_velocity_msg_ptr_.set(std::make_shared<Twist>(empty_twist));
 
   // Fill last two commands with default constructed commands
   previous_commands_.emplace(empty_twist);
   previous_commands_.emplace(empty_twist);
 
-  // initialize command subscriber
-  if (use_stamped_vel_)
+  // initialize command subscriber, on its own thread if configured
+  stop_command_thread();
+  rclcpp::SubscriptionOptions subscription_options;
+  if (command_thread_params_.enable)
   {
-    velocity_command_subscriber_ = node_->create_subscription<Twist>(
-      DEFAULT_COMMAND_TOPIC, rclcpp::SystemDefaultsQoS(),
-      [this](const std::shared_ptr<Twist> msg) -> void {
-        if (!subscriber_is_active_)
-        {
-          RCLCPP_WARN(node_->get_logger(), "Can't accept new commands. subscriber is inactive");
-          return;
-        }
-        if ((msg->header.stamp.sec == 0) && (msg->header.stamp.nanosec == 0))
-        {
-          RCLCPP_WARN_ONCE(
-            node_->get_logger(),
-            "Received TwistStamped with zero timestamp, setting it to current "
-            "time, this message will only be shown once");
-          msg->header.stamp = node_->get_clock()->now();
-        }
-        received_velocity_msg_ptr_.set(std::move(msg));
-      });
-  }
-  else
-  {
-    velocity_command_unstamped_subscriber_ = node_->create_subscription<geometry_msgs::msg::Twist>(
-      DEFAULT_COMMAND_UNSTAMPED_TOPIC, rclcpp::SystemDefaultsQoS(),
-      [this](const std::shared_ptr<geometry_msgs::msg::Twist> msg) -> void {
-        if (!subscriber_is_active_)
-        {
-          RCLCPP_WARN(node_->get_logger(), "Can't accept new commands. subscriber is inactive");
-          return;
-        }
-
-        // Write fake header in the stored stamped command
-        std::shared_ptr<Twist> twist_stamped;
-        received_velocity_msg_ptr_.get(twist_stamped);
-        twist_stamped->twist = *msg;
-        twist_stamped->header.stamp = node_->get_clock()->now();
-      });
+    start_command_thread();
+    subscription_options.callback_group = command_callback_group_;
   }
 
-  // initialize odometry publisher and messasge
-  odometry_publisher_ = node_->create_publisher<nav_msgs::msg::Odometry>(
-    DEFAULT_ODOMETRY_TOPIC, rclcpp::SystemDefaultsQoS());
-  realtime_odometry_publisher_ =
+  const auto subscribe = [this, &subscription_options](auto & node, size_t input, const std::string & topic) {
+    if (use_stamped_vel_)
+    {
+      command_subscribers_.push_back(node->template create_subscription<Twist>(
+        topic, rclcpp::SystemDefaultsQoS(),
+        [this, input](const std::shared_ptr<Twist> msg) -> void {
+          if (!subscriber_is_active_)
+          {
+            RCLCPP_WARN(node_->get_logger(), "Can't accept new commands. subscriber is inactive");
+            return;
+          }
+          if ((msg->header.stamp.sec == 0) && (msg->header.stamp.nanosec == 0))
+          {
+            RCLCPP_WARN_ONCE(
+              node_->get_logger(),
+              "Received TwistStamped with zero timestamp, setting it to current "
+              "time, this message will only be shown once");
+            msg->header.stamp = node_->get_clock()->now();
+          }
+          MuxCommand command;
+          command.stamp_ns = rclcpp::Time(msg->header.stamp).nanoseconds();
+          command.linear = msg->twist.linear.x;
+          command.angular = msg->twist.angular.z;
+          offer_command(input, command);
+        },
+        subscription_options));
+    }
+    else
+    {
+      command_unstamped_subscribers_.push_back(
+        node->template create_subscription<geometry_msgs::msg::Twist>(
+          topic, rclcpp::SystemDefaultsQoS(),
+          [this, input](const std::shared_ptr<geometry_msgs::msg::Twist> msg) -> void {
+            if (!subscriber_is_active_)
+            {
+              RCLCPP_WARN(node_->get_logger(), "Can't accept new commands. subscriber is inactive");
+              return;
+            }
+
+            // Stamp with the reception time
+            MuxCommand command;
+            command.stamp_ns = node_->get_clock()->now().nanoseconds();
+            command.linear = msg->linear.x;
+            command.angular = msg->angular.z;
+            offer_command(input, command);
+          },
+          subscription_options));
+    }
+  };
+  for (size_t input = 0; input < command_mux_.size(); ++input)
+  {
+    // inputs without a topic are fed from within the process
+    const auto & topic = command_input_topics_[input];
+    if (topic.empty())
+    {
+      continue;
+    }
+    if (command_node_)
+    {
+      subscribe(command_node_, input, topic);
+    }
+    else
+    {
+      subscribe(node_, input, topic);
+    }
+  }
+
+  // paths come at planner rate, the executor of the controller_manager keeps up with them
+  if (path_tracking_params_.enable)
+  {
+    path_subscriber_ = node_->create_subscription<nav_msgs::msg::Path>(
+      path_tracking_params_.topic, rclcpp::SystemDefaultsQoS(),
+      [this](const std::shared_ptr<nav_msgs::msg::Path> msg) -> void { receive_path(*msg); });
+  }
+
+  // the publisher threads are created along with the publishers and inherit this scheduling
+  ScopedThreadSchedule publisher_schedule(publisher_thread_schedule_);
+  if (!publisher_schedule.ok())
+  {
+    RCLCPP_WARN(
+      logger, "Publisher threads keep the default scheduling: %s",
+      publisher_schedule.error().c_str());
+  }
+
+  if (publish_limited_velocity_)
+  {
+    limited_velocity_publisher_ =
+      node_->create_publisher<Twist>(DEFAULT_COMMAND_OUT_TOPIC, rclcpp::SystemDefaultsQoS());
+    realtime_limited_velocity_publisher_ =
+      std::make_shared<realtime_tools::RealtimePublisher<Twist>>(limited_velocity_publisher_);
+  }
+
+  // initialize odometry publisher and messasge
+  odometry_publisher_ = node_->create_publisher<nav_msgs::msg::Odometry>(
+    DEFAULT_ODOMETRY_TOPIC, rclcpp::SystemDefaultsQoS());
+  realtime_odometry_publisher_ =
     std::make_shared<realtime_tools::RealtimePublisher<nav_msgs::msg::Odometry>>(
       odometry_publisher_);
 
-  auto & odometry_message = realtime_odometry_publisher_->msg_;
-  odometry_message.header.frame_id = odom_params_.odom_frame_id;
-  odometry_message.child_frame_id = odom_params_.base_frame_id;
+  auto & odometry_message = realtime_odometry_publisher_->msg_;
+  odometry_message.header.frame_id = odom_params_.odom_frame_id;
+  odometry_message.child_frame_id = odom_params_.base_frame_id;
+
+  // limit the publication on the topics /odom and /tf
+  publish_rate_ = node_->get_parameter("publish_rate").as_double();
+  publish_period_ = rclcpp::Duration::from_seconds(1.0 / publish_rate_);
+  previous_publish_timestamp_ = node_->get_clock()->now();
+
+  // initialize odom values zeros
+  odometry_message.twist =
+    geometry_msgs::msg::TwistWithCovariance(rosidl_runtime_cpp::MessageInitialization::ALL);
+
+  constexpr size_t NUM_DIMENSIONS = 6;
+  for (size_t index = 0; index < 6; ++index)
+  {
+    // 0, 7, 14, 21, 28, 35
+    const size_t diagonal_index = NUM_DIMENSIONS * index + index;
+    odometry_message.pose.covariance[diagonal_index] = odom_params_.pose_covariance_diagonal[index];
+    odometry_message.twist.covariance[diagonal_index] =
+      odom_params_.twist_covariance_diagonal[index];
+  }
+
+  // initialize transform publisher and message
+  odometry_transform_publisher_ = node_->create_publisher<tf2_msgs::msg::TFMessage>(
+    DEFAULT_TRANSFORM_TOPIC, rclcpp::SystemDefaultsQoS());
+  realtime_odometry_transform_publisher_ =
+    std::make_shared<realtime_tools::RealtimePublisher<tf2_msgs::msg::TFMessage>>(
+      odometry_transform_publisher_);
+
+  // keeping track of odom and base_link transforms only
+  auto & odometry_transform_message = realtime_odometry_transform_publisher_->msg_;
+  odometry_transform_message.transforms.resize(1);
+  odometry_transform_message.transforms.front().header.frame_id = odom_params_.odom_frame_id;
+  odometry_transform_message.transforms.front().child_frame_id = odom_params_.base_frame_id;
+
+  configure_calibration();
+
+  if (configure_tracking_monitor() == CallbackReturn::ERROR)
+  {
+    return CallbackReturn::ERROR;
+  }
+
+  if (!publisher_schedule.restore())
+  {
+    RCLCPP_WARN(logger, "%s", publisher_schedule.error().c_str());
+  }
+
+  if (configure_flight_recorder() == CallbackReturn::ERROR)
+  {
+    return CallbackReturn::ERROR;
+  }
+
+  // same for the threads writing the logs
+  ScopedThreadSchedule logger_schedule(logger_thread_schedule_);
+  if (!logger_schedule.ok())
+  {
+    RCLCPP_WARN(
+      logger, "Logger threads keep the default scheduling: %s", logger_schedule.error().c_str());
+  }
+
+  if (configure_telemetry() == CallbackReturn::ERROR)
+  {
+    return CallbackReturn::ERROR;
+  }
+
+  if (configure_capture() == CallbackReturn::ERROR)
+  {
+    return CallbackReturn::ERROR;
+  }
+
+  if (!logger_schedule.restore())
+  {
+    RCLCPP_WARN(logger, "%s", logger_schedule.error().c_str());
+  }
+
+  // schedules itself, see estimation_thread.policy
+  if (configure_estimation_thread() == CallbackReturn::ERROR)
+  {
+    return CallbackReturn::ERROR;
+  }
+
+  configure_claimed_states();
+
+  previous_update_timestamp_ = node_->get_clock()->now();
+  return CallbackReturn::SUCCESS;
+}
+
+void Ack6WDController::configure_calibration()
+{
+  auto logger = node_->get_logger();
+
+  calibration_params_.enable = node_->get_parameter("calibration.enable").as_bool();
+  calibration_params_.reference = node_->get_parameter("calibration.reference").as_string();
+  calibration_params_.reference_topic =
+    node_->get_parameter("calibration.reference_topic").as_string();
+  calibration_params_.forgetting_factor =
+    node_->get_parameter("calibration.forgetting_factor").as_double();
+  calibration_params_.min_linear_velocity =
+    node_->get_parameter("calibration.min_linear_velocity").as_double();
+  calibration_params_.min_angular_velocity =
+    node_->get_parameter("calibration.min_angular_velocity").as_double();
+
+  if (!calibration_params_.enable)
+  {
+    return;
+  }
+
+  if (odom_params_.open_loop)
+  {
+    RCLCPP_WARN(logger, "Online calibration needs closed loop odometry, disabling it");
+    calibration_params_.enable = false;
+    return;
+  }
+
+  calibration_ = OnlineCalibration(
+    calibration_params_.forgetting_factor, calibration_params_.min_linear_velocity,
+    calibration_params_.min_angular_velocity);
+  calibration_.reset();
+  calibration_reference_.writeFromNonRT(CalibrationReference());
+  last_calibration_reference_stamp_ns_ = 0;
+
+  if (calibration_params_.reference == "imu")
+  {
+    calibration_imu_subscriber_ = node_->create_subscription<sensor_msgs::msg::Imu>(
+      calibration_params_.reference_topic, rclcpp::SensorDataQoS(),
+      [this](const std::shared_ptr<sensor_msgs::msg::Imu> msg) -> void {
+        CalibrationReference reference;
+        reference.stamp_ns = rclcpp::Time(msg->header.stamp).nanoseconds();
+        reference.angular = msg->angular_velocity.z;
+        calibration_reference_.writeFromNonRT(reference);
+      });
+  }
+  else if (calibration_params_.reference == "odometry")
+  {
+    // differentiate the localization pose, its twist is often not filled
+    previous_reference_pose_ = nav_msgs::msg::Odometry();
+    calibration_pose_subscriber_ = node_->create_subscription<nav_msgs::msg::Odometry>(
+      calibration_params_.reference_topic, rclcpp::SystemDefaultsQoS(),
+      [this](const std::shared_ptr<nav_msgs::msg::Odometry> msg) -> void {
+        const auto yaw = [](const geometry_msgs::msg::Quaternion & q) {
+          return atan2(2.0 * (q.w * q.z + q.x * q.y), 1.0 - 2.0 * (q.y * q.y + q.z * q.z));
+        };
+
+        const auto & previous = previous_reference_pose_;
+        const double dt = (rclcpp::Time(msg->header.stamp) - rclcpp::Time(previous.header.stamp))
+                            .seconds();
+        if (previous.header.stamp.sec != 0 && dt > 0.0)
+        {
+          const double previous_yaw = yaw(previous.pose.pose.orientation);
+          const double dx = msg->pose.pose.position.x - previous.pose.pose.position.x;
+          const double dy = msg->pose.pose.position.y - previous.pose.pose.position.y;
+          const double dyaw = std::remainder(yaw(msg->pose.pose.orientation) - previous_yaw, 2 * M_PI);
+
+          CalibrationReference reference;
+          reference.stamp_ns = rclcpp::Time(msg->header.stamp).nanoseconds();
+          reference.linear = (dx * cos(previous_yaw) + dy * sin(previous_yaw)) / dt;
+          reference.angular = dyaw / dt;
+          reference.has_linear = true;
+          calibration_reference_.writeFromNonRT(reference);
+        }
+        previous_reference_pose_ = *msg;
+      });
+  }
+  else
+  {
+    RCLCPP_ERROR(
+      logger, "Unknown calibration reference '%s', expected 'imu' or 'odometry'",
+      calibration_params_.reference.c_str());
+    calibration_params_.enable = false;
+    return;
+  }
+
+  calibration_publisher_ = node_->create_publisher<std_msgs::msg::Float64MultiArray>(
+    DEFAULT_CALIBRATION_TOPIC, rclcpp::SystemDefaultsQoS());
+  realtime_calibration_publisher_ =
+    std::make_shared<realtime_tools::RealtimePublisher<std_msgs::msg::Float64MultiArray>>(
+      calibration_publisher_);
+
+  auto & calibration_message = realtime_calibration_publisher_->msg_;
+  calibration_message.layout.dim.resize(1);
+  calibration_message.layout.dim[0].label =
+    "wheel_radius,steering_angle_correction,angular_velocity_compensation";
+  calibration_message.layout.dim[0].size = 3;
+  calibration_message.layout.dim[0].stride = 3;
+  calibration_message.data.assign(3, 0.0);
+}
+
+void Ack6WDController::configure_claimed_states()
+{
+  const bool claim_all = node_->get_parameter("claim_all_state_interfaces").as_bool();
+  const bool closed_loop = !odom_params_.open_loop;
+
+  // the closed loop odometry integrates wheel velocities or positions, and steering angles
+  const bool velocity_odometry = closed_loop && !odom_params_.use_positions;
+  const bool position_odometry = closed_loop && odom_params_.use_positions;
+  claimed_states_.wheel_velocity = claim_all || velocity_odometry ||
+                                   slip_detection_params_.enable || tracking_monitor_params_.enable;
+  claimed_states_.steering_position = claim_all || closed_loop || tracking_monitor_params_.enable;
+  claimed_states_.middle_wheel_velocity =
+    claim_all || slip_detection_params_.enable || tracking_monitor_params_.enable;
+  claimed_states_.wheel_position = claim_all || position_odometry;
+  claimed_states_.middle_wheel_position = claim_all || position_odometry;
+
+  // nothing runs on these, the records show them when they are claimed anyway
+  claimed_states_.steering_velocity = claim_all;
+}
+
+void Ack6WDController::offer_command(size_t input, const MuxCommand & command)
+{
+  const auto result =
+    command_mux_.offer(input, command, node_->get_clock()->now().nanoseconds());
+  if (result != CommandMux::OFFER_ACCEPTED)
+  {
+    RCLCPP_WARN_THROTTLE(
+      node_->get_logger(), *node_->get_clock(), 1000,
+      "Rejected a %s command on input %s, %lu duplicates and %lu reordered so far",
+      result == CommandMux::OFFER_DUPLICATE ? "duplicate" : "reordered",
+      command_mux_.getInput(input).name.c_str(),
+      static_cast<unsigned long>(command_mux_.getDuplicateCount(input)),
+      static_cast<unsigned long>(command_mux_.getReorderedCount(input)));
+  }
+}
+
+CallbackReturn Ack6WDController::configure_command_mux()
+{
+  auto logger = node_->get_logger();
+
+  // the default input subscribes where the single cmd_vel subscriber used to
+  const auto input_names = node_->get_parameter("command_inputs").as_string_array();
+  if (input_names.empty())
+  {
+    RCLCPP_ERROR(logger, "command_inputs needs at least one input");
+    return CallbackReturn::ERROR;
+  }
+
+  // inputs fed from within the process, their source has to be the only writer of the input
+  std::vector<std::pair<std::string, std::string>> in_process_inputs;  // input, parameter
+  if (node_->get_parameter("shared_command.enable").as_bool())
+  {
+    in_process_inputs.emplace_back(
+      node_->get_parameter("shared_command.input").as_string(), "shared_command.input");
+  }
+  if (node_->get_parameter("reference_interfaces.enable").as_bool())
+  {
+    in_process_inputs.emplace_back(
+      node_->get_parameter("reference_interfaces.input").as_string(),
+      "reference_interfaces.input");
+  }
+  if (node_->get_parameter("path_tracking.enable").as_bool())
+  {
+    in_process_inputs.emplace_back(
+      node_->get_parameter("path_tracking.input").as_string(), "path_tracking.input");
+  }
+
+  std::vector<CommandMux::Input> inputs;
+  command_input_topics_.clear();
+  for (const auto & name : input_names)
+  {
+    const std::string prefix = "command_inputs." + name;
+    const bool is_default = name == DEFAULT_COMMAND_INPUT;
+    const auto in_process = std::find_if(
+      in_process_inputs.begin(), in_process_inputs.end(),
+      [&name](const std::pair<std::string, std::string> & input) { return input.first == name; });
+    std::string default_topic =
+      is_default ? (use_stamped_vel_ ? DEFAULT_COMMAND_TOPIC : DEFAULT_COMMAND_UNSTAMPED_TOPIC)
+                 : "~/" + name;
+    if (in_process != in_process_inputs.end())
+    {
+      default_topic = "";
+    }
+    auto_declare<std::string>(prefix + ".topic", default_topic);
+    auto_declare<int>(prefix + ".priority", 0);
+    auto_declare<double>(prefix + ".timeout", cmd_vel_timeout_.count() / 1000.0);
+
+    CommandMux::Input input;
+    input.name = name;
+    input.priority = node_->get_parameter(prefix + ".priority").as_int();
+    input.timeout_ns =
+      static_cast<int64_t>(node_->get_parameter(prefix + ".timeout").as_double() * 1e9);
+    inputs.push_back(input);
+    command_input_topics_.push_back(node_->get_parameter(prefix + ".topic").as_string());
+    if (in_process != in_process_inputs.end() && !command_input_topics_.back().empty())
+    {
+      RCLCPP_ERROR(
+        logger, "%s.topic must be empty, the input is fed by %s", prefix.c_str(),
+        in_process->second.c_str());
+      return CallbackReturn::ERROR;
+    }
+  }
+
+  std::string error;
+  if (!command_mux_.configure(inputs, error))
+  {
+    RCLCPP_ERROR(logger, "Invalid command_inputs: %s", error.c_str());
+    return CallbackReturn::ERROR;
+  }
+  selected_command_input_ = command_mux_.size();
+
+  const double stamp_tolerance = node_->get_parameter("command_stamp_check.tolerance").as_double();
+  if (!(stamp_tolerance >= 0.0))
+  {
+    RCLCPP_ERROR(logger, "command_stamp_check.tolerance must be >= 0");
+    return CallbackReturn::ERROR;
+  }
+  command_mux_.setStampCheck(
+    node_->get_parameter("command_stamp_check.enable").as_bool(),
+    static_cast<int64_t>(stamp_tolerance * 1e9));
+
+  shared_command_channel_.close();
+  if (node_->get_parameter("shared_command.enable").as_bool())
+  {
+    const auto input_name = node_->get_parameter("shared_command.input").as_string();
+    shared_command_input_ = command_mux_.find(input_name);
+    if (shared_command_input_ == command_mux_.size())
+    {
+      RCLCPP_ERROR(
+        logger, "shared_command.input [%s] is not one of command_inputs", input_name.c_str());
+      return CallbackReturn::ERROR;
+    }
+
+    const auto segment = node_->get_parameter("shared_command.segment").as_string();
+    if (!shared_command_channel_.open(segment, error))
+    {
+      RCLCPP_ERROR(logger, "%s", error.c_str());
+      return CallbackReturn::ERROR;
+    }
+  }
+
+  command_prediction_params_.enable = node_->get_parameter("command_prediction.enable").as_bool();
+  command_prediction_params_.order = node_->get_parameter("command_prediction.order").as_int();
+  command_prediction_params_.max_gap =
+    node_->get_parameter("command_prediction.max_gap").as_double();
+  command_prediction_params_.horizon =
+    node_->get_parameter("command_prediction.horizon").as_double();
+  if (
+    command_prediction_params_.order < 0 ||
+    command_prediction_params_.order > static_cast<int64_t>(CommandPredictor::MAX_ORDER) ||
+    !(command_prediction_params_.max_gap > 0.0) || !(command_prediction_params_.horizon >= 0.0))
+  {
+    RCLCPP_ERROR(
+      logger, "command_prediction needs an order in [0, %zu], a max_gap > 0 and a horizon >= 0",
+      CommandPredictor::MAX_ORDER);
+    return CallbackReturn::ERROR;
+  }
+  command_predictor_.configure(
+    static_cast<size_t>(command_prediction_params_.order), command_prediction_params_.max_gap,
+    command_prediction_params_.horizon);
+  return CallbackReturn::SUCCESS;
+}
+
+InterfaceRegistry::InterfacePtr Ack6WDController::export_interface(
+  const std::string & interface_name, double value)
+{
+  const std::string name = std::string(node_->get_name()) + "/" + interface_name;
+  std::string error;
+  auto exported = InterfaceRegistry::instance().exportInterface(name, value, error);
+  if (!exported)
+  {
+    RCLCPP_ERROR(node_->get_logger(), "%s", error.c_str());
+    return nullptr;
+  }
+  exported_interface_names_.push_back(name);
+  return exported;
+}
+
+void Ack6WDController::unexport_interfaces()
+{
+  for (const auto & name : exported_interface_names_)
+  {
+    InterfaceRegistry::instance().unexportInterface(name);
+  }
+  exported_interface_names_.clear();
+}
+
+CallbackReturn Ack6WDController::configure_reference_interfaces()
+{
+  linear_velocity_reference_.reset();
+  angular_velocity_reference_.reset();
+  if (!node_->get_parameter("reference_interfaces.enable").as_bool())
+  {
+    return CallbackReturn::SUCCESS;
+  }
+
+  const auto input_name = node_->get_parameter("reference_interfaces.input").as_string();
+  reference_input_ = command_mux_.find(input_name);
+  if (reference_input_ == command_mux_.size())
+  {
+    RCLCPP_ERROR(
+      node_->get_logger(), "reference_interfaces.input [%s] is not one of command_inputs",
+      input_name.c_str());
+    return CallbackReturn::ERROR;
+  }
+
+  // NaN until written, a writer sets both every cycle it commands
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  linear_velocity_reference_ = export_interface("linear/velocity", nan);
+  angular_velocity_reference_ = export_interface("angular/velocity", nan);
+  if (!linear_velocity_reference_ || !angular_velocity_reference_)
+  {
+    return CallbackReturn::ERROR;
+  }
+  return CallbackReturn::SUCCESS;
+}
+
+CallbackReturn Ack6WDController::configure_odometry_state_interfaces()
+{
+  odometry_state_interfaces_ = OdometryStateInterfaces();
+  if (!node_->get_parameter("odometry_state_interfaces.enable").as_bool())
+  {
+    return CallbackReturn::SUCCESS;
+  }
+
+  // the pose and twist of the odom message, the heading as yaw instead of a quaternion
+  odometry_state_interfaces_.x = export_interface("odometry/x", 0.0);
+  odometry_state_interfaces_.y = export_interface("odometry/y", 0.0);
+  odometry_state_interfaces_.heading = export_interface("odometry/heading", 0.0);
+  odometry_state_interfaces_.linear_velocity =
+    export_interface("odometry/linear_velocity", 0.0);
+  odometry_state_interfaces_.angular_velocity =
+    export_interface("odometry/angular_velocity", 0.0);
+  if (
+    !odometry_state_interfaces_.x || !odometry_state_interfaces_.y ||
+    !odometry_state_interfaces_.heading || !odometry_state_interfaces_.linear_velocity ||
+    !odometry_state_interfaces_.angular_velocity)
+  {
+    odometry_state_interfaces_ = OdometryStateInterfaces();
+    return CallbackReturn::ERROR;
+  }
+  return CallbackReturn::SUCCESS;
+}
+
+CallbackReturn Ack6WDController::configure_path_tracking()
+{
+  auto logger = node_->get_logger();
+  pure_pursuit_.clear();
+
+  path_tracking_params_.enable = node_->get_parameter("path_tracking.enable").as_bool();
+  if (!path_tracking_params_.enable)
+  {
+    return CallbackReturn::SUCCESS;
+  }
+  path_tracking_params_.topic = node_->get_parameter("path_tracking.topic").as_string();
+  path_tracking_params_.input = node_->get_parameter("path_tracking.input").as_string();
+  path_tracking_params_.max_points = node_->get_parameter("path_tracking.max_points").as_int();
+
+  auto & pursuit = path_tracking_params_.pursuit;
+  pursuit.speed = node_->get_parameter("path_tracking.speed").as_double();
+  pursuit.min_lookahead = node_->get_parameter("path_tracking.min_lookahead").as_double();
+  pursuit.max_lookahead = node_->get_parameter("path_tracking.max_lookahead").as_double();
+  pursuit.lookahead_time = node_->get_parameter("path_tracking.lookahead_time").as_double();
+  pursuit.goal_tolerance = node_->get_parameter("path_tracking.goal_tolerance").as_double();
+  pursuit.approach_deceleration =
+    node_->get_parameter("path_tracking.approach_deceleration").as_double();
+
+  path_input_ = command_mux_.find(path_tracking_params_.input);
+  if (path_input_ == command_mux_.size())
+  {
+    RCLCPP_ERROR(
+      logger, "path_tracking.input [%s] is not one of command_inputs",
+      path_tracking_params_.input.c_str());
+    return CallbackReturn::ERROR;
+  }
+  if (
+    path_tracking_params_.max_points < 1 || !(pursuit.speed > 0.0) ||
+    !(pursuit.min_lookahead > 0.0) || !(pursuit.max_lookahead >= pursuit.min_lookahead) ||
+    !(pursuit.lookahead_time >= 0.0) || !(pursuit.goal_tolerance > 0.0) ||
+    !(pursuit.approach_deceleration >= 0.0))
+  {
+    RCLCPP_ERROR(
+      logger,
+      "path_tracking needs max_points >= 1, speed > 0, 0 < min_lookahead <= max_lookahead, "
+      "goal_tolerance > 0 and lookahead_time, approach_deceleration >= 0");
+    return CallbackReturn::ERROR;
+  }
+  pure_pursuit_.configure(pursuit);
+
+  // paths are copied into these while the loop runs
+  const auto capacity = static_cast<size_t>(path_tracking_params_.max_points);
+  path_buffer_.initialize([capacity](TrackedPath & path) {
+    path.points.clear();
+    path.points.reserve(capacity);
+    path.arc_lengths.clear();
+    path.arc_lengths.reserve(capacity);
+  });
+  return CallbackReturn::SUCCESS;
+}
+
+bool Ack6WDController::discard_path()
+{
+  if (!discard_path_.exchange(false))
+  {
+    return false;
+  }
+  // also the path published last, the reader buffer is only read after the next setPath()
+  pure_pursuit_.clear();
+  path_buffer_.update();
+  return true;
+}
+
+void Ack6WDController::receive_path(const nav_msgs::msg::Path & path)
+{
+  auto logger = node_->get_logger();
+  if (!subscriber_is_active_)
+  {
+    RCLCPP_WARN(logger, "Can't accept new paths. subscriber is inactive");
+    return;
+  }
+  if (!path.header.frame_id.empty() && path.header.frame_id != odom_params_.odom_frame_id)
+  {
+    RCLCPP_WARN(
+      logger, "Ignoring a path in frame %s, it has to be in %s", path.header.frame_id.c_str(),
+      odom_params_.odom_frame_id.c_str());
+    return;
+  }
+
+  std::vector<PathPoint> points;
+  points.reserve(path.poses.size());
+  for (const auto & pose : path.poses)
+  {
+    points.push_back({pose.pose.position.x, pose.pose.position.y});
+  }
+
+  // an empty path stops tracking
+  if (!path_buffer_.writeBuffer().assign(points))
+  {
+    RCLCPP_WARN(
+      logger, "Ignoring a path of %zu poses, path_tracking.max_points is %ld", points.size(),
+      static_cast<long>(path_tracking_params_.max_points));
+    return;
+  }
+  path_buffer_.publish();
+}
+
+CallbackReturn Ack6WDController::configure_estop()
+{
+  estop_params_.enable = node_->get_parameter("estop.enable").as_bool();
+  estop_params_.interface = node_->get_parameter("estop.interface").as_string();
+  estop_params_.active_high = node_->get_parameter("estop.active_high").as_bool();
+  if (estop_params_.enable && estop_params_.interface.find('/') == std::string::npos)
+  {
+    RCLCPP_ERROR(
+      node_->get_logger(), "estop.interface must be <name>/<interface>, got [%s]",
+      estop_params_.interface.c_str());
+    return CallbackReturn::ERROR;
+  }
+  return CallbackReturn::SUCCESS;
+}
+
+CallbackReturn Ack6WDController::configure_zone_map()
+{
+  zone_map_params_.enable = node_->get_parameter("zone_map.enable").as_bool();
+  zone_map_params_.file = node_->get_parameter("zone_map.file").as_string();
+  zone_map_params_.resolution = node_->get_parameter("zone_map.resolution").as_double();
+  zone_map_params_.margin = node_->get_parameter("zone_map.margin").as_double();
+
+  zone_map_.clear();
+  if (!zone_map_params_.enable)
+  {
+    return CallbackReturn::SUCCESS;
+  }
+
+  std::string error;
+  if (!zone_map_.load(
+        zone_map_params_.file, zone_map_params_.resolution, zone_map_params_.margin, error))
+  {
+    RCLCPP_ERROR(node_->get_logger(), "%s", error.c_str());
+    return CallbackReturn::ERROR;
+  }
+  RCLCPP_INFO(
+    node_->get_logger(), "Loaded %zu speed limit zones from %s", zone_map_.getZoneCount(),
+    zone_map_params_.file.c_str());
+  return CallbackReturn::SUCCESS;
+}
+
+CallbackReturn Ack6WDController::configure_feasible_command()
+{
+  auto logger = node_->get_logger();
+
+  feasible_command_params_.max_steering_angle =
+    node_->get_parameter("max_steering_angle").as_double();
+  if (
+    !(feasible_command_params_.max_steering_angle > 0.0) ||
+    feasible_command_params_.max_steering_angle > M_PI / 2)
+  {
+    RCLCPP_ERROR(logger, "max_steering_angle must be in (0, pi/2]");
+    return CallbackReturn::ERROR;
+  }
+
+  const auto policy = node_->get_parameter("feasible_command.policy").as_string();
+  if (policy == "preserve_speed")
+  {
+    feasible_command_params_.policy = PRESERVE_SPEED;
+  }
+  else if (policy == "preserve_curvature")
+  {
+    feasible_command_params_.policy = PRESERVE_CURVATURE;
+  }
+  else
+  {
+    RCLCPP_ERROR(
+      logger, "feasible_command.policy must be preserve_speed or preserve_curvature, got [%s]",
+      policy.c_str());
+    return CallbackReturn::ERROR;
+  }
+  return CallbackReturn::SUCCESS;
+}
+
+CallbackReturn Ack6WDController::configure_joint_transforms()
+{
+  auto logger = node_->get_logger();
+
+  const size_t wheel_count =
+    left_wheel_names_.size() + right_wheel_names_.size() + middle_wheel_names_.size();
+  const size_t joint_count = wheel_count + left_steering_names_.size() + right_steering_names_.size();
+
+  // wheels keep the hardware direction, the rear steerings mirror the front ones
+  std::vector<JointTransform> transforms(joint_count);
+  const double wheel_scale = node_->get_parameter("joint_transform.wheel_scale").as_double();
+  const double steering_scale = node_->get_parameter("joint_transform.steering_scale").as_double();
+  for (size_t joint = 0; joint < joint_count; ++joint)
+  {
+    transforms[joint].scale = joint < wheel_count ? wheel_scale : steering_scale;
+  }
+  for (size_t index = 0; index < left_steering_names_.size(); ++index)
+  {
+    transforms[wheel_count + index].sign = index == 0 ? 1.0 : -1.0;
+  }
+  for (size_t index = 0; index < right_steering_names_.size(); ++index)
+  {
+    transforms[wheel_count + left_steering_names_.size() + index].sign = index == 0 ? -1.0 : 1.0;
+  }
+
+  // per joint overrides, empty keeps the defaults
+  const auto override_field = [&](const std::string & name, double JointTransform::* field) {
+    const auto values = node_->get_parameter("joint_transform." + name).as_double_array();
+    if (values.empty())
+    {
+      return true;
+    }
+    if (values.size() != joint_count)
+    {
+      RCLCPP_ERROR(
+        logger, "joint_transform.%s needs one entry per joint [%zu], got [%zu]", name.c_str(),
+        joint_count, values.size());
+      return false;
+    }
+    for (size_t joint = 0; joint < joint_count; ++joint)
+    {
+      transforms[joint].*field = values[joint];
+    }
+    return true;
+  };
+  if (!override_field("signs", &JointTransform::sign) ||
+      !override_field("offsets", &JointTransform::offset) ||
+      !override_field("lower_limits", &JointTransform::lower_limit) ||
+      !override_field("upper_limits", &JointTransform::upper_limit))
+  {
+    return CallbackReturn::ERROR;
+  }
+
+  std::string error;
+  if (!joint_transforms_.configure(transforms, error))
+  {
+    RCLCPP_ERROR(logger, "Invalid joint_transform: %s", error.c_str());
+    return CallbackReturn::ERROR;
+  }
+
+  joint_commands_.assign(joint_count, 0.0);
+  joint_states_.assign(joint_count, 0.0);
+  return configure_change_mask();
+}
+
+CallbackReturn Ack6WDController::configure_change_mask()
+{
+  auto logger = node_->get_logger();
+
+  change_mask_params_.enable = node_->get_parameter("change_mask.enable").as_bool();
+  change_mask_params_.interface = node_->get_parameter("change_mask.interface").as_string();
+  change_mask_params_.wheel_deadband =
+    node_->get_parameter("change_mask.wheel_deadband").as_double();
+  change_mask_params_.steering_deadband =
+    node_->get_parameter("change_mask.steering_deadband").as_double();
+  change_mask_params_.refresh_cycles = node_->get_parameter("change_mask.refresh_cycles").as_int();
+  if (!change_mask_params_.enable)
+  {
+    return CallbackReturn::SUCCESS;
+  }
+
+  if (change_mask_params_.interface.find('/') == std::string::npos)
+  {
+    RCLCPP_ERROR(
+      logger, "change_mask.interface must be <name>/<interface>, got [%s]",
+      change_mask_params_.interface.c_str());
+    return CallbackReturn::ERROR;
+  }
+
+  if (change_mask_params_.refresh_cycles < 0)
+  {
+    RCLCPP_ERROR(
+      logger, "change_mask.refresh_cycles must be >= 0, got [%ld]",
+      static_cast<long>(change_mask_params_.refresh_cycles));
+    return CallbackReturn::ERROR;
+  }
+
+  const size_t joint_count = joint_commands_.size();
+  const size_t wheel_count =
+    left_wheel_names_.size() + right_wheel_names_.size() + middle_wheel_names_.size();
+  std::vector<double> deadbands = node_->get_parameter("change_mask.deadbands").as_double_array();
+  if (deadbands.empty())
+  {
+    for (size_t joint = 0; joint < joint_count; ++joint)
+    {
+      deadbands.push_back(
+        joint < wheel_count ? change_mask_params_.wheel_deadband
+                            : change_mask_params_.steering_deadband);
+    }
+  }
+  else if (deadbands.size() != joint_count)
+  {
+    RCLCPP_ERROR(
+      logger, "change_mask.deadbands needs one entry per joint [%zu], got [%zu]", joint_count,
+      deadbands.size());
+    return CallbackReturn::ERROR;
+  }
+
+  std::string error;
+  if (!change_filter_.configure(
+        deadbands, static_cast<size_t>(change_mask_params_.refresh_cycles), error))
+  {
+    RCLCPP_ERROR(logger, "Invalid change_mask: %s", error.c_str());
+    return CallbackReturn::ERROR;
+  }
+  return CallbackReturn::SUCCESS;
+}
+
+CallbackReturn Ack6WDController::configure_tracking_monitor()
+{
+  auto logger = node_->get_logger();
+
+  tracking_monitor_params_.enable = node_->get_parameter("tracking_monitor.enable").as_bool();
+  tracking_monitor_params_.max_lag = node_->get_parameter("tracking_monitor.max_lag").as_int();
+  tracking_monitor_params_.smoothing =
+    node_->get_parameter("tracking_monitor.smoothing").as_double();
+  tracking_monitor_params_.wheel_error_threshold =
+    node_->get_parameter("tracking_monitor.wheel_error_threshold").as_double();
+  tracking_monitor_params_.steering_error_threshold =
+    node_->get_parameter("tracking_monitor.steering_error_threshold").as_double();
+
+  if (!tracking_monitor_params_.enable)
+  {
+    return CallbackReturn::SUCCESS;
+  }
+
+  if (tracking_monitor_params_.max_lag < 0 || tracking_monitor_params_.smoothing <= 0.0 ||
+      tracking_monitor_params_.smoothing > 1.0)
+  {
+    RCLCPP_ERROR(
+      logger, "Tracking monitor needs max_lag >= 0 and smoothing in (0, 1], got [%ld] and [%f]",
+      static_cast<long>(tracking_monitor_params_.max_lag), tracking_monitor_params_.smoothing);
+    return CallbackReturn::ERROR;
+  }
+
+  const size_t joint_count = left_wheel_names_.size() + right_wheel_names_.size() +
+                             middle_wheel_names_.size() + left_steering_names_.size() +
+                             right_steering_names_.size();
+  if (joint_count > 32)
+  {
+    RCLCPP_ERROR(logger, "Tracking monitor supports up to 32 joints, got [%zu]", joint_count);
+    return CallbackReturn::ERROR;
+  }
+
+  tracking_monitor_.configure(
+    joint_count, static_cast<size_t>(tracking_monitor_params_.max_lag),
+    tracking_monitor_params_.smoothing);
+  written_commands_.assign(joint_count, 0.0);
+  measured_states_.assign(joint_count, 0.0);
+  has_written_commands_ = false;
+
+  tracking_error_publisher_ = node_->create_publisher<std_msgs::msg::Float64MultiArray>(
+    DEFAULT_TRACKING_ERROR_TOPIC, rclcpp::SystemDefaultsQoS());
+  realtime_tracking_error_publisher_ =
+    std::make_shared<realtime_tools::RealtimePublisher<std_msgs::msg::Float64MultiArray>>(
+      tracking_error_publisher_);
+
+  // one row per quantity, one column per joint in command interface order
+  auto & tracking_message = realtime_tracking_error_publisher_->msg_;
+  tracking_message.layout.dim.resize(2);
+  tracking_message.layout.dim[0].label = "rms_error,lagged_rms_error,lag";
+  tracking_message.layout.dim[0].size = 3;
+  tracking_message.layout.dim[0].stride = 3 * joint_count;
+  tracking_message.layout.dim[1].label = "joints";
+  tracking_message.layout.dim[1].size = joint_count;
+  tracking_message.layout.dim[1].stride = joint_count;
+  tracking_message.data.assign(3 * joint_count, 0.0);
+  return CallbackReturn::SUCCESS;
+}
+
+CallbackReturn Ack6WDController::configure_flight_recorder()
+{
+  auto logger = node_->get_logger();
+
+  flight_recorder_params_.enable = node_->get_parameter("flight_recorder.enable").as_bool();
+  flight_recorder_params_.path = node_->get_parameter("flight_recorder.path").as_string();
+  flight_recorder_params_.capacity = node_->get_parameter("flight_recorder.capacity").as_int();
+  flight_recorder_params_.deadline = node_->get_parameter("flight_recorder.deadline").as_double();
+
+  flight_recorder_.release();
+  flight_record_service_.reset();
+  if (!flight_recorder_params_.enable)
+  {
+    return CallbackReturn::SUCCESS;
+  }
+
+  const size_t joint_count = left_wheel_names_.size() + right_wheel_names_.size() +
+                             middle_wheel_names_.size() + left_steering_names_.size() +
+                             right_steering_names_.size();
+  if (joint_count > FLIGHT_RECORD_MAX_JOINTS)
+  {
+    RCLCPP_ERROR(
+      logger, "Flight recorder supports up to %zu joints, got [%zu]", FLIGHT_RECORD_MAX_JOINTS,
+      joint_count);
+    return CallbackReturn::ERROR;
+  }
+
+  if (flight_recorder_params_.capacity <= 0)
+  {
+    RCLCPP_ERROR(
+      logger, "Flight recorder capacity must be > 0, got [%ld]",
+      static_cast<long>(flight_recorder_params_.capacity));
+    return CallbackReturn::ERROR;
+  }
+
+  std::string error;
+  if (!flight_recorder_.configure(
+        flight_recorder_params_.path, static_cast<size_t>(flight_recorder_params_.capacity),
+        error))
+  {
+    RCLCPP_ERROR(logger, "%s", error.c_str());
+    return CallbackReturn::ERROR;
+  }
+  flight_recorder_failed_ = false;
+  flight_recorder_overran_ = false;
+  flight_record_requested_ = false;
+
+  // the dump itself is done by the next update, from the control loop
+  flight_record_service_ = node_->create_service<std_srvs::srv::Trigger>(
+    DEFAULT_FLIGHT_RECORD_SERVICE,
+    [this](
+      const std::shared_ptr<std_srvs::srv::Trigger::Request>,
+      std::shared_ptr<std_srvs::srv::Trigger::Response> response) -> void {
+      flight_record_requested_ = true;
+      response->success = true;
+      response->message = "Flight record will be dumped to " + flight_recorder_params_.path;
+    });
+
+  RCLCPP_INFO(
+    logger, "Flight recorder keeps the last %ld cycles, dumps go to %s",
+    static_cast<long>(flight_recorder_params_.capacity), flight_recorder_params_.path.c_str());
+  return CallbackReturn::SUCCESS;
+}
+
+std::vector<TelemetryColumn> Ack6WDController::telemetry_columns() const
+{
+  // the values of a FlightRecord, see fill_telemetry_sample
+  const double time_step = telemetry_params_.time_step;
+  const double velocity_step = telemetry_params_.velocity_step;
+  const double position_step = telemetry_params_.position_step;
+  std::vector<TelemetryColumn> columns = {
+    {"period", time_step},
+    {"execution_time", time_step},
+    {"events", 1.0},
+    {"command_linear", velocity_step},
+    {"command_angular", velocity_step},
+    {"limited_linear", velocity_step},
+    {"limited_angular", velocity_step},
+    {"odometry_x", position_step},
+    {"odometry_y", position_step},
+    {"odometry_heading", position_step},
+    {"odometry_linear", velocity_step},
+    {"odometry_angular", velocity_step},
+  };
+  const auto add_joints = [&columns, velocity_step, position_step](
+                            const std::vector<std::string> & names, bool is_wheel) {
+    for (const auto & name : names)
+    {
+      columns.push_back({name + "/position", position_step});
+      columns.push_back({name + "/velocity", velocity_step});
+      columns.push_back({name + "/command", is_wheel ? velocity_step : position_step});
+    }
+  };
+  add_joints(left_wheel_names_, true);
+  add_joints(right_wheel_names_, true);
+  add_joints(middle_wheel_names_, true);
+  add_joints(left_steering_names_, false);
+  add_joints(right_steering_names_, false);
+  return columns;
+}
+
+CallbackReturn Ack6WDController::configure_telemetry()
+{
+  auto logger = node_->get_logger();
+
+  telemetry_params_.enable = node_->get_parameter("telemetry.enable").as_bool();
+  telemetry_params_.path = node_->get_parameter("telemetry.path").as_string();
+  telemetry_params_.chunk_rows = node_->get_parameter("telemetry.chunk_rows").as_int();
+  telemetry_params_.queue_size = node_->get_parameter("telemetry.queue_size").as_int();
+  telemetry_params_.velocity_step = node_->get_parameter("telemetry.velocity_step").as_double();
+  telemetry_params_.position_step = node_->get_parameter("telemetry.position_step").as_double();
+  telemetry_params_.time_step = node_->get_parameter("telemetry.time_step").as_double();
+
+  telemetry_writer_.close();
+  capture_writer_.close();
+  if (!telemetry_params_.enable)
+  {
+    return CallbackReturn::SUCCESS;
+  }
 
-  // limit the publication on the topics /odom and /tf
-  publish_rate_ = node_->get_parameter("publish_rate").as_double();
-  publish_period_ = rclcpp::Duration::from_seconds(1.0 / publish_rate_);
-  previous_publish_timestamp_ = node_->get_clock()->now();
+  if (telemetry_params_.chunk_rows <= 0 || telemetry_params_.queue_size <= 0)
+  {
+    RCLCPP_ERROR(
+      logger, "Telemetry chunk_rows and queue_size must be > 0, got [%ld] and [%ld]",
+      static_cast<long>(telemetry_params_.chunk_rows),
+      static_cast<long>(telemetry_params_.queue_size));
+    return CallbackReturn::ERROR;
+  }
 
-  // initialize odom values zeros
-  odometry_message.twist =
-    geometry_msgs::msg::TwistWithCovariance(rosidl_runtime_cpp::MessageInitialization::ALL);
+  const size_t joint_count = left_wheel_names_.size() + right_wheel_names_.size() +
+                             middle_wheel_names_.size() + left_steering_names_.size() +
+                             right_steering_names_.size();
+  if (joint_count > FLIGHT_RECORD_MAX_JOINTS)
+  {
+    RCLCPP_ERROR(
+      logger, "Telemetry supports up to %zu joints, got [%zu]", FLIGHT_RECORD_MAX_JOINTS,
+      joint_count);
+    return CallbackReturn::ERROR;
+  }
 
-  constexpr size_t NUM_DIMENSIONS = 6;
-  for (size_t index = 0; index < 6; ++index)
+  std::string error;
+  if (!telemetry_writer_.open(
+        telemetry_params_.path, telemetry_columns(), static_cast<size_t>(telemetry_params_.chunk_rows),
+        static_cast<size_t>(telemetry_params_.queue_size), error))
   {
-    // 0, 7, 14, 21, 28, 35
-    const size_t diagonal_index = NUM_DIMENSIONS * index + index;
-    odometry_message.pose.covariance[diagonal_index] = odom_params_.pose_covariance_diagonal[index];
-    odometry_message.twist.covariance[diagonal_index] =
-      odom_params_.twist_covariance_diagonal[index];
+    RCLCPP_ERROR(logger, "%s", error.c_str());
+    return CallbackReturn::ERROR;
   }
 
-  // initialize transform publisher and message
-  odometry_transform_publisher_ = node_->create_publisher<tf2_msgs::msg::TFMessage>(
-    DEFAULT_TRANSFORM_TOPIC, rclcpp::SystemDefaultsQoS());
-  realtime_odometry_transform_publisher_ =
-    std::make_shared<realtime_tools::RealtimePublisher<tf2_msgs::msg::TFMessage>>(
-      odometry_transform_publisher_);
+  RCLCPP_INFO(logger, "Logging telemetry to %s", telemetry_params_.path.c_str());
+  return CallbackReturn::SUCCESS;
+}
 
-  // keeping track of odom and base_link transforms only
-  auto & odometry_transform_message = realtime_odometry_transform_publisher_->msg_;
-  odometry_transform_message.transforms.resize(1);
-  odometry_transform_message.transforms.front().header.frame_id = odom_params_.odom_frame_id;
-  odometry_transform_message.transforms.front().child_frame_id = odom_params_.base_frame_id;
+CallbackReturn Ack6WDController::configure_estimation_thread()
+{
+  auto logger = node_->get_logger();
 
-  previous_update_timestamp_ = node_->get_clock()->now();
+  estimation_thread_params_.enable = node_->get_parameter("estimation_thread.enable").as_bool();
+  estimation_thread_params_.queue_size =
+    node_->get_parameter("estimation_thread.queue_size").as_int();
+
+  std::string error;
+  if (!parse_thread_schedule(
+        node_->get_parameter("estimation_thread.policy").as_string(),
+        node_->get_parameter("estimation_thread.priority").as_int(),
+        node_->get_parameter("estimation_thread.cpu_affinity").as_integer_array(),
+        estimation_thread_schedule_, error))
+  {
+    RCLCPP_ERROR(logger, "Invalid estimation_thread: %s", error.c_str());
+    return CallbackReturn::ERROR;
+  }
+
+  if (!estimation_thread_params_.enable)
+  {
+    return CallbackReturn::SUCCESS;
+  }
+
+  if (odom_params_.open_loop)
+  {
+    RCLCPP_WARN(logger, "Open loop odometry has nothing to estimate, not starting the thread");
+    estimation_thread_params_.enable = false;
+    return CallbackReturn::SUCCESS;
+  }
+
+  if (estimation_thread_params_.queue_size <= 0)
+  {
+    RCLCPP_ERROR(
+      logger, "Estimation thread queue_size must be > 0, got [%ld]",
+      static_cast<long>(estimation_thread_params_.queue_size));
+    return CallbackReturn::ERROR;
+  }
+
+  start_estimation_thread();
+  return CallbackReturn::SUCCESS;
+}
+
+CallbackReturn Ack6WDController::configure_capture()
+{
+  auto logger = node_->get_logger();
+
+  capture_params_.enable = node_->get_parameter("capture.enable").as_bool();
+  capture_params_.path = node_->get_parameter("capture.path").as_string();
+  capture_params_.triggers = node_->get_parameter("capture.triggers").as_string_array();
+  capture_params_.pre_trigger_cycles =
+    node_->get_parameter("capture.pre_trigger_cycles").as_int();
+  capture_params_.post_trigger_cycles =
+    node_->get_parameter("capture.post_trigger_cycles").as_int();
+  capture_params_.deadline = node_->get_parameter("capture.deadline").as_double();
+  capture_params_.queue_size = node_->get_parameter("capture.queue_size").as_int();
+
+  capture_writer_.close();
+  if (!capture_params_.enable)
+  {
+    return CallbackReturn::SUCCESS;
+  }
+
+  const std::pair<const char *, uint32_t> trigger_names[] = {
+    {"error", EVENT_ERROR},
+    {"overrun", EVENT_OVERRUN},
+    {"invalid_state", EVENT_INVALID_STATE},
+    {"limiter_saturation", EVENT_LIMITER_SATURATION},
+    {"cmd_vel_timeout", EVENT_COMMAND_TIMEOUT},
+    {"tracking_error", EVENT_TRACKING_ERROR},
+    {"estop", EVENT_ESTOP},
+  };
+  capture_trigger_mask_ = 0;
+  for (const auto & trigger : capture_params_.triggers)
+  {
+    const auto it = std::find_if(
+      std::begin(trigger_names), std::end(trigger_names),
+      [&trigger](const std::pair<const char *, uint32_t> & name) { return trigger == name.first; });
+    if (it == std::end(trigger_names))
+    {
+      RCLCPP_ERROR(logger, "Unknown capture trigger '%s'", trigger.c_str());
+      return CallbackReturn::ERROR;
+    }
+    capture_trigger_mask_ |= it->second;
+  }
+
+  if (capture_params_.pre_trigger_cycles < 0 || capture_params_.post_trigger_cycles < 0 ||
+      capture_params_.queue_size <= 0)
+  {
+    RCLCPP_ERROR(
+      logger, "Capture needs pre_trigger_cycles, post_trigger_cycles >= 0 and queue_size > 0");
+    return CallbackReturn::ERROR;
+  }
+
+  const size_t joint_count = left_wheel_names_.size() + right_wheel_names_.size() +
+                             middle_wheel_names_.size() + left_steering_names_.size() +
+                             right_steering_names_.size();
+  if (joint_count > FLIGHT_RECORD_MAX_JOINTS)
+  {
+    RCLCPP_ERROR(
+      logger, "Capture supports up to %zu joints, got [%zu]", FLIGHT_RECORD_MAX_JOINTS,
+      joint_count);
+    return CallbackReturn::ERROR;
+  }
+
+  capture_window_.configure(
+    static_cast<size_t>(capture_params_.pre_trigger_cycles),
+    static_cast<size_t>(capture_params_.post_trigger_cycles));
+
+  // captures are rare, small chunks get them to disk soon after they end
+  std::string error;
+  if (!capture_writer_.open(
+        capture_params_.path, telemetry_columns(), CAPTURE_CHUNK_ROWS,
+        static_cast<size_t>(capture_params_.queue_size), error))
+  {
+    RCLCPP_ERROR(logger, "%s", error.c_str());
+    return CallbackReturn::ERROR;
+  }
+
+  RCLCPP_INFO(logger, "Capturing triggered windows to %s", capture_params_.path.c_str());
   return CallbackReturn::SUCCESS;
 }
 
+void Ack6WDController::estimate(EstimationInput & input, OdometryEstimate & output)
+{
+  const size_t wheels_per_side = wheel_params_.wheels_per_side;
+  double velocity_encoder = 0.0;
+  double angle_encoder = 0.0;
+
+  if (slip_detection_params_.enable)
+  {
+    // steering of the turn the wheels are measured in
+    fuse_wheel_states(
+      input.left_wheel_velocities, input.right_wheel_velocities, input.left_steering_angles,
+      input.right_steering_angles, wheels_per_side, angle_encoder, velocity_encoder);
+
+    const size_t slipping = slip_detector_.update(
+      angle_encoder, input.wheel_base, input.wheel_separation, input.left_wheel_radius,
+      input.right_wheel_radius, input.left_wheel_velocities, input.right_wheel_velocities,
+      input.middle_wheel_velocities);
+    if (slipping > 0)
+    {
+      RCLCPP_WARN_THROTTLE(
+        node_->get_logger(), *node_->get_clock(), 1000, "%zu wheels are slipping, wheel mask 0x%x",
+        slipping, slip_detector_.getSlipMask());
+    }
+    output.slip_mask = slip_detector_.getSlipMask();
+  }
+
+  if (odom_params_.use_positions)
+  {
+    integrate_wheel_positions(input);
+  }
+  else
+  {
+    fuse_wheel_states(
+      input.left_wheel_velocities, input.right_wheel_velocities, input.left_steering_angles,
+      input.right_steering_angles, wheels_per_side, angle_encoder, velocity_encoder);
+    odometry_.updateVel(angle_encoder, velocity_encoder, input.stamp);
+  }
+
+  if (calibration_params_.enable)
+  {
+    const auto & reference = *calibration_reference_.readFromRT();
+    if (reference.stamp_ns != last_calibration_reference_stamp_ns_)
+    {
+      last_calibration_reference_stamp_ns_ = reference.stamp_ns;
+      calibration_.update(
+        input.command_linear, input.command_angular, odometry_.getLinear(),
+        odometry_.getAngular(), reference.linear, reference.angular, reference.has_linear);
+    }
+
+    const auto suggestion = calibration_.suggest(
+      input.wheel_radius, input.steering_angle_correction, input.angular_velocity_compensation);
+    output.suggested_wheel_radius = suggestion.wheel_radius;
+    output.suggested_steering_angle_correction = suggestion.steering_angle_correction;
+    output.suggested_angular_velocity_compensation = suggestion.angular_velocity_compensation;
+  }
+
+  output.stamp_ns = input.stamp.nanoseconds();
+  output.x = odometry_.getX();
+  output.y = odometry_.getY();
+  output.heading = odometry_.getHeading();
+  output.linear = odometry_.getLinear();
+  output.angular = odometry_.getAngular();
+}
+
+void Ack6WDController::integrate_wheel_positions(const EstimationInput & input)
+{
+  // steered wheels on the front axle first, the rear axle steers the other way
+  const double half_separation = input.wheel_separation / 2;
+  const double half_base = input.wheel_base / 2;
+  const double radians_per_tick = 2 * M_PI / position_odometry_params_.ticks_per_revolution;
+  const double ticks_per_position = position_odometry_params_.ticks_per_position_unit;
+
+  double distances[2 * MAX_WHEELS_PER_SIDE + 2];
+  double angles[2 * MAX_WHEELS_PER_SIDE + 2];
+  double x[2 * MAX_WHEELS_PER_SIDE + 2];
+  double y[2 * MAX_WHEELS_PER_SIDE + 2];
+  size_t count = 0;
+  const auto add_wheel = [&](double position, double radius, double wheel_x, double wheel_y, double angle) {
+    // joints are flattened in the same order: left, right, then middle wheels
+    const int64_t ticks = wheel_ticks_[count].accumulate(position * ticks_per_position);
+    distances[count] = joint_transforms_.getSign(count) *
+                       static_cast<double>(ticks - integrated_ticks_[count]) * radians_per_tick *
+                       radius;
+    angles[count] = angle;
+    x[count] = wheel_x;
+    y[count] = wheel_y;
+    ++count;
+  };
+
+  // wheels of a side from the front to the rear axle, evenly spaced like the middle wheels
+  // of a 6WD chassis half way between them
+  const size_t wheels_per_side = wheel_params_.wheels_per_side;
+  const auto axle_x = [half_separation, wheels_per_side](size_t index) {
+    return wheels_per_side > 1
+             ? half_separation - 2 * half_separation * index / (wheels_per_side - 1)
+             : half_separation;
+  };
+  for (size_t index = 0; index < wheels_per_side; ++index)
+  {
+    const bool front = index == 0;
+    add_wheel(
+      input.left_wheel_positions[index], input.left_wheel_radius, axle_x(index), half_base,
+      front ? input.left_steering_angles[index] : -input.left_steering_angles[index]);
+  }
+  for (size_t index = 0; index < wheels_per_side; ++index)
+  {
+    const bool front = index == 0;
+    add_wheel(
+      input.right_wheel_positions[index], input.right_wheel_radius, axle_x(index), -half_base,
+      front ? input.right_steering_angles[index] : -input.right_steering_angles[index]);
+  }
+  for (size_t index = 0; index < middle_wheel_names_.size(); ++index)
+  {
+    // middle right wheel first
+    const bool right = index == 0;
+    add_wheel(
+      input.middle_wheel_positions[index], right ? input.right_wheel_radius : input.left_wheel_radius,
+      0.0, right ? -half_base : half_base, 0.0);
+  }
+
+  double linear = 0.0;
+  double angular = 0.0;
+  if (
+    fit_base_displacement(distances, angles, x, y, count, linear, angular) &&
+    odometry_.updateDisplacement(linear, angular, input.stamp))
+  {
+    for (size_t index = 0; index < count; ++index)
+    {
+      integrated_ticks_[index] = wheel_ticks_[index].getTicks();
+    }
+  }
+}
+
+void Ack6WDController::start_estimation_thread()
+{
+  stop_estimation_thread();
+
+  estimation_queue_.reset(
+    new SpscQueue<EstimationInput>(static_cast<size_t>(estimation_thread_params_.queue_size)));
+  estimation_output_.write(OdometryEstimate());
+  sem_init(&estimation_semaphore_, 0, 0);
+
+  const auto logger = node_->get_logger();
+  const ThreadSchedule schedule = estimation_thread_schedule_;
+  estimation_thread_running_ = true;
+  estimation_thread_ = std::thread([this, schedule, logger]() {
+    std::string error;
+    if (!apply_thread_schedule(schedule, error))
+    {
+      RCLCPP_WARN(logger, "Estimation thread keeps the default scheduling: %s", error.c_str());
+    }
+
+    EstimationInput input;
+    OdometryEstimate output;
+    while (true)
+    {
+      // posted once per pushed input, and once more to stop
+      if (sem_wait(&estimation_semaphore_) != 0)
+      {
+        continue;  // EINTR
+      }
+      if (!estimation_thread_running_)
+      {
+        break;
+      }
+      while (estimation_queue_->pop(input))
+      {
+        estimate(input, output);
+        estimation_output_.write(output);
+      }
+    }
+  });
+}
+
+void Ack6WDController::stop_estimation_thread()
+{
+  if (estimation_thread_.joinable())
+  {
+    estimation_thread_running_ = false;
+    sem_post(&estimation_semaphore_);
+    estimation_thread_.join();
+    sem_destroy(&estimation_semaphore_);
+  }
+  estimation_queue_.reset();
+}
+
+void Ack6WDController::start_command_thread()
+{
+  auto logger = node_->get_logger();
+
+  // a node of its own, the executor of the controller node does not get to its callbacks
+  command_node_ = std::make_shared<rclcpp::Node>(
+    std::string(node_->get_name()) + "_cmd_vel", node_->get_namespace());
+  command_callback_group_ =
+    command_node_->create_callback_group(rclcpp::CallbackGroupType::MutuallyExclusive);
+  command_executor_ = std::make_shared<rclcpp::executors::SingleThreadedExecutor>();
+  command_executor_->add_node(command_node_);
+
+  ThreadSchedule schedule;
+  if (command_thread_params_.priority > 0)
+  {
+    schedule.policy = SCHED_FIFO;
+    schedule.priority = static_cast<int>(command_thread_params_.priority);
+  }
+  schedule.cpu_affinity.assign(
+    command_thread_params_.cpu_affinity.begin(), command_thread_params_.cpu_affinity.end());
+
+  command_thread_running_ = true;
+  command_thread_ = std::thread([this, schedule, logger]() {
+    std::string error;
+    if (!apply_thread_schedule(schedule, error))
+    {
+      RCLCPP_WARN(logger, "cmd_vel thread keeps the default scheduling: %s", error.c_str());
+    }
+    while (command_thread_running_)
+    {
+      command_executor_->spin_once(COMMAND_THREAD_SPIN_TIMEOUT);
+    }
+  });
+}
+
+void Ack6WDController::stop_command_thread()
+{
+  if (command_thread_.joinable())
+  {
+    command_thread_running_ = false;
+    command_thread_.join();
+  }
+  command_subscribers_.clear();
+  command_unstamped_subscribers_.clear();
+  if (command_executor_)
+  {
+    command_executor_->remove_node(command_node_);
+  }
+  command_executor_.reset();
+  command_callback_group_.reset();
+  command_node_.reset();
+}
+
+void Ack6WDController::update_tracking_monitor(double period)
+{
+  // commands as they are on the interfaces now, i.e. written by the previous cycle
+  size_t joint = 0;
+  const auto read_wheels = [this, &joint](const std::vector<WheelHandle> & handles) {
+    for (const auto & handle : handles)
+    {
+      written_commands_[joint] = handle.velocity.get().get_value();
+      measured_states_[joint] = handle.encoder_velocity->get_value();
+      ++joint;
+    }
+  };
+  const auto read_steerings = [this, &joint](const std::vector<SteeringHandle> & handles) {
+    for (const auto & handle : handles)
+    {
+      written_commands_[joint] = handle.position.get().get_value();
+      measured_states_[joint] = handle.encoder_position->get_value();
+      ++joint;
+    }
+  };
+  read_wheels(registered_left_wheel_handles_);
+  read_wheels(registered_right_wheel_handles_);
+  read_wheels(registered_middle_wheel_handles_);
+  const size_t wheel_count = joint;
+  read_steerings(registered_left_steering_handles_);
+  read_steerings(registered_right_steering_handles_);
+
+  if (!has_written_commands_)
+  {
+    return;
+  }
+
+  for (size_t index = 0; index < joint; ++index)
+  {
+    if (std::isnan(written_commands_[index]) || std::isnan(measured_states_[index]))
+    {
+      return;
+    }
+  }
+  tracking_monitor_.update(written_commands_.data(), measured_states_.data(), period);
+
+  uint32_t degraded_mask = 0;
+  for (size_t index = 0; index < joint; ++index)
+  {
+    const double threshold = index < wheel_count ? tracking_monitor_params_.wheel_error_threshold
+                                                 : tracking_monitor_params_.steering_error_threshold;
+    if (threshold > 0.0 && tracking_monitor_.getRmsError(index) > threshold)
+    {
+      degraded_mask |= 1u << index;
+    }
+  }
+  if (degraded_mask != 0)
+  {
+    flight_recorder_.current().events |= EVENT_TRACKING_ERROR;
+    RCLCPP_WARN_THROTTLE(
+      node_->get_logger(), *node_->get_clock(), 1000,
+      "Joints are not tracking their commands, joint mask 0x%x", degraded_mask);
+  }
+}
+
 CallbackReturn Ack6WDController::on_activate(const rclcpp_lifecycle::State &)
 {
-  const auto left_wheel_result =
-    configure_side_wheel("left", left_wheel_names_, registered_left_wheel_handles_);
-  const auto right_wheel_result =
-    configure_side_wheel("right", right_wheel_names_, registered_right_wheel_handles_);
+  const auto left_wheel_result = configure_side_wheel(
+    "left", left_wheel_names_, claimed_states_.wheel_position, claimed_states_.wheel_velocity,
+    registered_left_wheel_handles_);
+  const auto right_wheel_result = configure_side_wheel(
+    "right", right_wheel_names_, claimed_states_.wheel_position, claimed_states_.wheel_velocity,
+    registered_right_wheel_handles_);
   const auto left_steering_result =
     configure_side_steering("left", left_steering_names_, registered_left_steering_handles_);
   const auto right_steering_result =
     configure_side_steering("right", right_steering_names_, registered_right_steering_handles_);
 
-  const auto middle_wheel_result =
-    configure_side_wheel("middle", middle_wheel_names_, registered_middle_wheel_handles_);
+  const auto middle_wheel_result = configure_side_wheel(
+    "middle", middle_wheel_names_, claimed_states_.middle_wheel_position,
+    claimed_states_.middle_wheel_velocity, registered_middle_wheel_handles_);
 
   if (left_wheel_result == CallbackReturn::ERROR || right_wheel_result == CallbackReturn::ERROR
       || left_steering_result == CallbackReturn::ERROR || right_steering_result == CallbackReturn::ERROR
@@ -748,6 +2790,72 @@ CallbackReturn Ack6WDController::on_activate(const rclcpp_lifecycle::State &)
     return CallbackReturn::ERROR;
   }
 
+  // all joints in one flat array, in the order of the transforms
+  joint_command_interfaces_.clear();
+  joint_state_interfaces_.clear();
+  const auto add_wheels = [this](const std::vector<WheelHandle> & handles) {
+    for (const auto & handle : handles)
+    {
+      joint_command_interfaces_.push_back(handle.velocity);
+      joint_state_interfaces_.push_back(handle.encoder_velocity);
+    }
+  };
+  const auto add_steerings = [this](const std::vector<SteeringHandle> & handles) {
+    for (const auto & handle : handles)
+    {
+      joint_command_interfaces_.push_back(handle.position);
+      joint_state_interfaces_.push_back(handle.encoder_position);
+    }
+  };
+  add_wheels(registered_left_wheel_handles_);
+  add_wheels(registered_right_wheel_handles_);
+  add_wheels(registered_middle_wheel_handles_);
+  add_steerings(registered_left_steering_handles_);
+  add_steerings(registered_right_steering_handles_);
+
+  change_mask_interface_ = nullptr;
+  if (change_mask_params_.enable)
+  {
+    const auto command_handle = std::find_if(
+      command_interfaces_.begin(), command_interfaces_.end(), [this](const auto & interface) {
+        return interface.get_name() + "/" + interface.get_interface_name() ==
+               change_mask_params_.interface;
+      });
+    if (command_handle == command_interfaces_.end())
+    {
+      RCLCPP_ERROR(
+        node_->get_logger(), "Unable to obtain change mask command handle %s",
+        change_mask_params_.interface.c_str());
+      return CallbackReturn::ERROR;
+    }
+    change_mask_interface_ = &(*command_handle);
+    // the drives may hold anything, send everything first
+    change_filter_.reset();
+  }
+
+  estop_interface_ = nullptr;
+  estop_engaged_ = false;
+  if (estop_params_.enable)
+  {
+    const auto state_handle = std::find_if(
+      state_interfaces_.cbegin(), state_interfaces_.cend(), [this](const auto & interface) {
+        return interface.get_name() + "/" + interface.get_interface_name() ==
+               estop_params_.interface;
+      });
+    if (state_handle == state_interfaces_.cend())
+    {
+      RCLCPP_ERROR(
+        node_->get_logger(), "Unable to obtain e-stop state handle %s",
+        estop_params_.interface.c_str());
+      return CallbackReturn::ERROR;
+    }
+    estop_interface_ = &(*state_handle);
+  }
+
+  // the hardware may hold anything before the first command of this activation
+  has_written_commands_ = false;
+  tracking_monitor_.reset();
+
   is_halted = false;
   subscriber_is_active_ = true;
 
@@ -758,6 +2866,8 @@ CallbackReturn Ack6WDController::on_activate(const rclcpp_lifecycle::State &)
 CallbackReturn Ack6WDController::on_deactivate(const rclcpp_lifecycle::State &)
 {
   subscriber_is_active_ = false;
+  // a path received before deactivation is not resumed, dropped by the control loop
+  discard_path_ = true;
   return CallbackReturn::SUCCESS;
 }
 
@@ -768,7 +2878,7 @@ CallbackReturn Ack6WDController::on_cleanup(const rclcpp_lifecycle::State &)
     return CallbackReturn::ERROR;
   }
 
-  received_velocity_msg_ptr_.set(std::make_shared<Twist>());
+  command_mux_.clear();
   return CallbackReturn::SUCCESS;
 }
 
@@ -783,7 +2893,15 @@ CallbackReturn Ack6WDController::on_error(const rclcpp_lifecycle::State &)
 
 bool Ack6WDController::reset()
 {
+  // owns the odometry while running
+  stop_estimation_thread();
   odometry_.resetOdometry();
+  odometry_estimate_ = OdometryEstimate();
+  for (auto & ticks : wheel_ticks_)
+  {
+    ticks.reset();
+  }
+  std::fill(integrated_ticks_.begin(), integrated_ticks_.end(), 0);
 
   // release the old queue
   std::queue<Twist> empty;
@@ -796,11 +2914,30 @@ bool Ack6WDController::reset()
   registered_left_steering_handles_.clear();
   registered_right_steering_handles_.clear();
 
-  subscriber_is_active_ = false;
-  velocity_command_subscriber_.reset();
-  velocity_command_unstamped_subscriber_.reset();
+  joint_command_interfaces_.clear();
+  joint_state_interfaces_.clear();
+  change_mask_interface_ = nullptr;
+  estop_interface_ = nullptr;
 
-  received_velocity_msg_ptr_.set(nullptr);
+  subscriber_is_active_ = false;
+  stop_command_thread();
+
+  calibration_imu_subscriber_.reset();
+  calibration_pose_subscriber_.reset();
+
+  flight_record_service_.reset();
+  flight_recorder_.release();
+  telemetry_writer_.close();
+  capture_writer_.close();
+
+  command_mux_.clear();
+  shared_command_channel_.close();
+  linear_velocity_reference_.reset();
+  angular_velocity_reference_.reset();
+  odometry_state_interfaces_ = OdometryStateInterfaces();
+  unexport_interfaces();
+  path_subscriber_.reset();
+  pure_pursuit_.clear();
   is_halted = false;
   return true;
 }
@@ -810,55 +2947,42 @@ CallbackReturn Ack6WDController::on_shutdown(const rclcpp_lifecycle::State &)
   return CallbackReturn::SUCCESS;
 }
 
-int Ack6WDController::quadrant(double linear, double angular){
-  // Quadrant
-  // 0 | 1
-  // -----
-  // 3 | 2
+void Ack6WDController::halt()
+{
+  // zero velocity and straight steering, as the hardware sees them
+  std::fill(joint_commands_.begin(), joint_commands_.end(), 0.0);
+  write_joint_commands();
+}
 
-  if (linear > 0) {
-    if (angular >= 0) {
-      return 0;
-    } else {
-      return 1;
-    }
-  } else {
-    if (angular > 0) {
-      return 2;
-    } else {
-      return 3;
-    }
+void Ack6WDController::write_joint_commands()
+{
+  joint_transforms_.apply(joint_commands_.data(), joint_commands_.data());
+  if (change_mask_interface_ != nullptr)
+  {
+    // the hardware sends the dirty joints only, the others keep their last value
+    const uint32_t mask = change_filter_.update(joint_commands_.data());
+    change_mask_interface_->set_value(static_cast<double>(mask));
+  }
+  for (size_t joint = 0; joint < joint_command_interfaces_.size(); ++joint)
+  {
+    joint_command_interfaces_[joint].get().set_value(joint_commands_[joint]);
   }
 }
 
-void Ack6WDController::halt()
+const hardware_interface::LoanedStateInterface * Ack6WDController::find_state_interface(
+  const std::string & joint_name, const std::string & interface_name) const
 {
-  const auto halt_wheels = [](auto & wheel_handles) {
-    for (const auto & wheel_handle : wheel_handles)
-    {
-      wheel_handle.velocity.get().set_value(0.0);
-    }
-  };
-
-  halt_wheels(registered_left_wheel_handles_);
-  halt_wheels(registered_right_wheel_handles_);
-
-  halt_wheels(registered_middle_wheel_handles_);
-
-  const auto halt_steerings = [](auto & steering_handles) {
-    for (const auto & steering_handle : steering_handles)
-    {
-      steering_handle.position.get().set_value(0.0);
-    }
-  };
-
-  halt_steerings(registered_left_steering_handles_);
-  halt_steerings(registered_right_steering_handles_);
+  const auto state_handle = std::find_if(
+    state_interfaces_.cbegin(), state_interfaces_.cend(),
+    [&joint_name, &interface_name](const auto & interface) {
+      return interface.get_name() == joint_name && interface.get_interface_name() == interface_name;
+    });
+  return state_handle != state_interfaces_.cend() ? &(*state_handle) : nullptr;
 }
 
 CallbackReturn Ack6WDController::configure_side_wheel(
-  const std::string & side, const std::vector<std::string> & wheel_names,
-  std::vector<WheelHandle> & registered_handles)
+  const std::string & side, const std::vector<std::string> & wheel_names, bool claim_position,
+  bool claim_velocity, std::vector<WheelHandle> & registered_handles)
 {
   auto logger = node_->get_logger();
 
@@ -872,25 +2996,19 @@ CallbackReturn Ack6WDController::configure_side_wheel(
   registered_handles.reserve(wheel_names.size());
   for (const auto & wheel_name : wheel_names)
   {
-    const auto state_handle_pos = std::find_if(
-      state_interfaces_.cbegin(), state_interfaces_.cend(), [&wheel_name](const auto & interface) {
-        return interface.get_name() == wheel_name &&
-               interface.get_interface_name() == HW_IF_POSITION;
-      });
+    const auto state_handle_pos =
+      claim_position ? find_state_interface(wheel_name, HW_IF_POSITION) : nullptr;
 
-    if (state_handle_pos == state_interfaces_.cend())
+    if (claim_position && state_handle_pos == nullptr)
     {
       RCLCPP_ERROR(logger, "Unable to obtain wheel joint state position handle for %s", wheel_name.c_str());
       return CallbackReturn::ERROR;
     }
 
-    const auto state_handle_vel = std::find_if(
-      state_interfaces_.cbegin(), state_interfaces_.cend(), [&wheel_name](const auto & interface) {
-        return interface.get_name() == wheel_name &&
-               interface.get_interface_name() == HW_IF_VELOCITY;
-      });
+    const auto state_handle_vel =
+      claim_velocity ? find_state_interface(wheel_name, HW_IF_VELOCITY) : nullptr;
 
-    if (state_handle_vel == state_interfaces_.cend())
+    if (claim_velocity && state_handle_vel == nullptr)
     {
       RCLCPP_ERROR(logger, "Unable to obtain wheel joint state velocity handle for %s", wheel_name.c_str());
       return CallbackReturn::ERROR;
@@ -910,7 +3028,7 @@ CallbackReturn Ack6WDController::configure_side_wheel(
     }
 
     registered_handles.emplace_back(
-      WheelHandle{std::ref(*state_handle_pos), std::ref(*state_handle_vel), std::ref(*command_handle)});
+      WheelHandle{state_handle_pos, state_handle_vel, std::ref(*command_handle)});
   }
 
   return CallbackReturn::SUCCESS;
@@ -932,25 +3050,19 @@ CallbackReturn Ack6WDController::configure_side_steering(
   registered_handles.reserve(steering_names.size());
   for (const auto & steering_name : steering_names)
   {
-    const auto state_handle_pos = std::find_if(
-      state_interfaces_.cbegin(), state_interfaces_.cend(), [&steering_name](const auto & interface) {
-        return interface.get_name() == steering_name &&
-               interface.get_interface_name() == HW_IF_POSITION;
-      });
+    const auto state_handle_pos = claimed_states_.steering_position ?
+      find_state_interface(steering_name, HW_IF_POSITION) : nullptr;
 
-    if (state_handle_pos == state_interfaces_.cend())
+    if (claimed_states_.steering_position && state_handle_pos == nullptr)
     {
       RCLCPP_ERROR(logger, "Unable to obtain joint state position handle for %s", steering_name.c_str());
       return CallbackReturn::ERROR;
     }
 
-    const auto state_handle_vel = std::find_if(
-      state_interfaces_.cbegin(), state_interfaces_.cend(), [&steering_name](const auto & interface) {
-        return interface.get_name() == steering_name &&
-               interface.get_interface_name() == HW_IF_VELOCITY;
-      });
+    const auto state_handle_vel = claimed_states_.steering_velocity ?
+      find_state_interface(steering_name, HW_IF_VELOCITY) : nullptr;
 
-    if (state_handle_vel == state_interfaces_.cend())
+    if (claimed_states_.steering_velocity && state_handle_vel == nullptr)
     {
       RCLCPP_ERROR(logger, "Unable to obtain joint state velocity handle for %s", steering_name.c_str());
       return CallbackReturn::ERROR;
@@ -970,7 +3082,7 @@ CallbackReturn Ack6WDController::configure_side_steering(
     }
 
     registered_handles.emplace_back(
-      SteeringHandle{std::ref(*state_handle_pos), std::ref(*state_handle_pos), std::ref(*command_handle)});
+      SteeringHandle{state_handle_pos, state_handle_vel, std::ref(*command_handle)});
   }
 
   return CallbackReturn::SUCCESS;
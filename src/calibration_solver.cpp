@@ -0,0 +1,425 @@
+// Copyright 2021 Faiz Pangestu
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Maintainer : Faiz Pangestu
+ */
+
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+#include "ack_6wd_controller/calibration_solver.hpp"
+#include "ack_6wd_controller/kinematics.hpp"
+#include "ack_6wd_controller/parallel_for.hpp"
+
+namespace
+{
+using ack_6wd_controller::CalibrationSample;
+using ack_6wd_controller::Pose2D;
+
+double sign(double value) { return value < 0.0 ? -1.0 : 1.0; }
+
+/**
+ * \brief Body velocity of a sample, Ackermann model of Odometry::updateVel using both sides
+ *
+ * Each side gives a yaw rate through its distance to the instantaneous center of rotation,
+ * their mean is used.
+ */
+void body_velocity(
+  const CalibrationSample & sample, const double * parameters, double & linear, double & angular)
+{
+  const double radius = parameters[0];
+  const double separation = parameters[1];
+  const double base = parameters[2];
+  const double left_velocity = sample.left_velocity * radius * parameters[3];
+  const double right_velocity = sample.right_velocity * radius * parameters[4];
+  const double angle = sample.angle * parameters[5];
+
+  if (std::abs(angle) < 1e-6)
+  {
+    linear = 0.5 * (left_velocity + right_velocity);
+    angular = 0.0;
+    return;
+  }
+
+  const double turning_radius = (base / 2) * sign(angle) + (separation / 2) / tan(angle);
+  const double inner_radius = (separation / 2) / sin(angle);
+  const double outer_radius =
+    sign(angle) * std::hypot(std::abs(turning_radius) + base / 2, separation / 2);
+
+  const double inner_velocity = angle > 0.0 ? left_velocity : right_velocity;
+  const double outer_velocity = angle > 0.0 ? right_velocity : left_velocity;
+
+  angular = 0.5 * (inner_velocity / inner_radius + outer_velocity / outer_radius);
+  linear = turning_radius * angular;
+}
+
+void integrate(Pose2D & pose, double linear, double angular)
+{
+  if (std::abs(angular) < 1e-6)
+  {
+    const double direction = pose.heading + angular * 0.5;
+    pose.x += linear * cos(direction);
+    pose.y += linear * sin(direction);
+    pose.heading += angular;
+  }
+  else
+  {
+    const double heading_old = pose.heading;
+    const double r = linear / angular;
+    pose.heading += angular;
+    pose.x += r * (sin(pose.heading) - sin(heading_old));
+    pose.y += -r * (cos(pose.heading) - cos(heading_old));
+  }
+}
+
+/**
+ * \brief Solve the symmetric positive definite system a x = b in place with Cholesky
+ * \return false if a is not positive definite
+ */
+template <size_t N>
+bool solve_cholesky(std::array<std::array<double, N>, N> a, std::array<double, N> & b)
+{
+  for (size_t j = 0; j < N; ++j)
+  {
+    double diagonal = a[j][j];
+    for (size_t k = 0; k < j; ++k)
+    {
+      diagonal -= a[j][k] * a[j][k];
+    }
+    if (diagonal <= 0.0)
+    {
+      return false;
+    }
+    a[j][j] = std::sqrt(diagonal);
+    for (size_t i = j + 1; i < N; ++i)
+    {
+      double value = a[i][j];
+      for (size_t k = 0; k < j; ++k)
+      {
+        value -= a[i][k] * a[j][k];
+      }
+      a[i][j] = value / a[j][j];
+    }
+  }
+
+  for (size_t i = 0; i < N; ++i)
+  {
+    for (size_t k = 0; k < i; ++k)
+    {
+      b[i] -= a[i][k] * b[k];
+    }
+    b[i] /= a[i][i];
+  }
+  for (size_t i = N; i-- > 0;)
+  {
+    for (size_t k = i + 1; k < N; ++k)
+    {
+      b[i] -= a[k][i] * b[k];
+    }
+    b[i] /= a[i][i];
+  }
+  return true;
+}
+
+double squared_norm(const std::vector<double> & values)
+{
+  double sum = 0.0;
+  for (const double value : values)
+  {
+    sum += value * value;
+  }
+  return sum;
+}
+}  // namespace
+
+namespace ack_6wd_controller
+{
+std::vector<CalibrationSample> make_calibration_samples(
+  const JointStateLog & log, size_t wheels_per_side, double velocity_scale)
+{
+  std::vector<CalibrationSample> samples;
+  samples.reserve(log.size());
+
+  std::vector<double> left_velocities(wheels_per_side);
+  std::vector<double> right_velocities(wheels_per_side);
+  for (size_t row = 0; row < log.size(); ++row)
+  {
+    const double * velocities = log.velocity_row(row);
+    const double * left_angles = log.position_row(row) + 2 * wheels_per_side;
+    const double * right_angles = log.position_row(row) + 3 * wheels_per_side;
+
+    double left_mean = 0.0;
+    double right_mean = 0.0;
+    for (size_t index = 0; index < wheels_per_side; ++index)
+    {
+      left_velocities[index] = velocities[index] * velocity_scale;
+      right_velocities[index] = velocities[wheels_per_side + index] * velocity_scale;
+      left_mean += std::abs(left_velocities[index]);
+      right_mean += std::abs(right_velocities[index]);
+    }
+
+    double angle = 0.0;
+    double velocity = 0.0;
+    fuse_wheel_states(
+      left_velocities.data(), right_velocities.data(), left_angles, right_angles, wheels_per_side,
+      angle, velocity);
+    if (std::isnan(angle) || std::isnan(velocity))
+    {
+      continue;
+    }
+
+    CalibrationSample sample;
+    sample.stamp = log.stamps[row].seconds();
+    sample.left_velocity = sign(velocity) * left_mean / wheels_per_side;
+    sample.right_velocity = sign(velocity) * right_mean / wheels_per_side;
+    sample.angle = angle;
+    samples.push_back(sample);
+  }
+
+  return samples;
+}
+
+CalibrationSolver::CalibrationSolver(
+  std::vector<CalibrationSample> samples, const PoseLog & ground_truth, const Options & options)
+: samples_(std::move(samples)), options_(options)
+{
+  std::sort(
+    samples_.begin(), samples_.end(),
+    [](const CalibrationSample & a, const CalibrationSample & b) { return a.stamp < b.stamp; });
+
+  const auto sample_after = [this](double stamp) {
+    return static_cast<size_t>(
+      std::upper_bound(
+        samples_.begin(), samples_.end(), stamp,
+        [](double value, const CalibrationSample & sample) { return value < sample.stamp; }) -
+      samples_.begin());
+  };
+
+  size_t start = 0;
+  while (start + 1 < ground_truth.size())
+  {
+    const double start_stamp = ground_truth.stamps[start].seconds();
+    size_t end = start + 1;
+    while (end + 1 < ground_truth.size() &&
+           ground_truth.stamps[end].seconds() - start_stamp < options_.window_duration)
+    {
+      ++end;
+    }
+
+    Window window;
+    window.first_sample = sample_after(start_stamp);
+    window.end_sample = sample_after(ground_truth.stamps[end].seconds());
+    window.start_stamp = start_stamp;
+    window.end_stamp = ground_truth.stamps[end].seconds();
+
+    // ground truth motion expressed in the window start frame
+    const Pose2D & from = ground_truth.poses[start];
+    const Pose2D & to = ground_truth.poses[end];
+    const double dx = to.x - from.x;
+    const double dy = to.y - from.y;
+    window.relative_motion.x = cos(from.heading) * dx + sin(from.heading) * dy;
+    window.relative_motion.y = -sin(from.heading) * dx + cos(from.heading) * dy;
+    window.relative_motion.heading = std::remainder(to.heading - from.heading, 2 * M_PI);
+
+    if (window.end_sample > window.first_sample)
+    {
+      windows_.push_back(window);
+    }
+    start = end;
+  }
+}
+
+void CalibrationSolver::evaluate(
+  const CalibrationParameters & parameters, std::vector<double> & residuals) const
+{
+  const Vector vector{
+    {parameters.wheel_radius, parameters.wheel_separation, parameters.wheel_base,
+     parameters.left_wheel_radius_multiplier, parameters.right_wheel_radius_multiplier,
+     parameters.steering_angle_correction}};
+  evaluate_with_prior(vector, vector, residuals);
+  residuals.resize(3 * windows_.size());
+}
+
+void CalibrationSolver::evaluate_with_prior(
+  const Vector & parameters, const Vector & prior, std::vector<double> & residuals) const
+{
+  residuals.resize(3 * windows_.size() + PARAMETER_COUNT);
+
+  parallel_for(windows_.size(), options_.thread_count, [&](size_t index) {
+    const Window & window = windows_[index];
+
+    // integrate each sample velocity up to the next stamp, the last one up to the window end
+    Pose2D pose;
+    double previous_stamp = window.start_stamp;
+    double linear = 0.0;
+    double angular = 0.0;
+    for (size_t i = window.first_sample; i < window.end_sample; ++i)
+    {
+      const double dt = samples_[i].stamp - previous_stamp;
+      integrate(pose, linear * dt, angular * dt);
+      body_velocity(samples_[i], parameters.data(), linear, angular);
+      previous_stamp = samples_[i].stamp;
+    }
+    if (window.end_stamp > previous_stamp)
+    {
+      const double dt = window.end_stamp - previous_stamp;
+      integrate(pose, linear * dt, angular * dt);
+    }
+
+    residuals[3 * index] = pose.x - window.relative_motion.x;
+    residuals[3 * index + 1] = pose.y - window.relative_motion.y;
+    residuals[3 * index + 2] = options_.heading_weight *
+      std::remainder(pose.heading - window.relative_motion.heading, 2 * M_PI);
+  });
+
+  // relative deviation from the prior, weighted to stay comparable with the window count
+  const double prior_scale = std::sqrt(options_.prior_weight * windows_.size());
+  for (size_t i = 0; i < PARAMETER_COUNT; ++i)
+  {
+    residuals[3 * windows_.size() + i] =
+      prior_scale * (parameters[i] - prior[i]) / std::max(std::abs(prior[i]), 1e-3);
+  }
+}
+
+CalibrationParameters CalibrationSolver::solve(
+  const CalibrationParameters & initial, Summary & summary) const
+{
+  Vector prior{
+    {initial.wheel_radius, initial.wheel_separation, initial.wheel_base,
+     initial.left_wheel_radius_multiplier, initial.right_wheel_radius_multiplier,
+     initial.steering_angle_correction}};
+  Vector parameters = prior;
+
+  std::vector<double> residuals;
+  std::vector<double> perturbed_residuals;
+  std::vector<std::vector<double>> jacobian(PARAMETER_COUNT);
+
+  evaluate_with_prior(parameters, prior, residuals);
+  double cost = 0.5 * squared_norm(residuals);
+
+  summary = Summary();
+  summary.initial_cost = cost;
+  summary.window_count = windows_.size();
+
+  double damping = 1e-3;
+  for (size_t iteration = 0; iteration < options_.max_iterations; ++iteration)
+  {
+    summary.iterations = iteration + 1;
+
+    // forward difference jacobian, one column per parameter
+    for (size_t j = 0; j < PARAMETER_COUNT; ++j)
+    {
+      const double step = 1e-6 * std::max(std::abs(parameters[j]), 1e-3);
+      Vector perturbed = parameters;
+      perturbed[j] += step;
+      evaluate_with_prior(perturbed, prior, perturbed_residuals);
+
+      jacobian[j].resize(residuals.size());
+      for (size_t i = 0; i < residuals.size(); ++i)
+      {
+        jacobian[j][i] = (perturbed_residuals[i] - residuals[i]) / step;
+      }
+    }
+
+    std::array<std::array<double, PARAMETER_COUNT>, PARAMETER_COUNT> normal{};
+    Vector gradient{};
+    for (size_t j = 0; j < PARAMETER_COUNT; ++j)
+    {
+      for (size_t i = 0; i < residuals.size(); ++i)
+      {
+        gradient[j] -= jacobian[j][i] * residuals[i];
+      }
+      for (size_t k = 0; k <= j; ++k)
+      {
+        double value = 0.0;
+        for (size_t i = 0; i < residuals.size(); ++i)
+        {
+          value += jacobian[j][i] * jacobian[k][i];
+        }
+        normal[j][k] = value;
+        normal[k][j] = value;
+      }
+    }
+
+    // Levenberg-Marquardt: raise the damping until a step lowers the cost
+    bool improved = false;
+    double step_norm = 0.0;
+    while (!improved && damping < 1e12)
+    {
+      auto damped = normal;
+      for (size_t j = 0; j < PARAMETER_COUNT; ++j)
+      {
+        damped[j][j] += damping * std::max(normal[j][j], 1e-12);
+      }
+
+      Vector step = gradient;
+      if (!solve_cholesky(damped, step))
+      {
+        damping *= 10.0;
+        continue;
+      }
+
+      Vector candidate = parameters;
+      step_norm = 0.0;
+      for (size_t j = 0; j < PARAMETER_COUNT; ++j)
+      {
+        candidate[j] += step[j];
+        step_norm = std::max(step_norm, std::abs(step[j]) / std::max(std::abs(parameters[j]), 1e-3));
+      }
+
+      evaluate_with_prior(candidate, prior, perturbed_residuals);
+      const double candidate_cost = 0.5 * squared_norm(perturbed_residuals);
+      if (candidate_cost < cost)
+      {
+        const double improvement = (cost - candidate_cost) / std::max(cost, 1e-300);
+        parameters = candidate;
+        std::swap(residuals, perturbed_residuals);
+        cost = candidate_cost;
+        damping = std::max(damping / 10.0, 1e-12);
+        improved = true;
+
+        if (improvement < 1e-12)
+        {
+          step_norm = 0.0;
+        }
+      }
+      else
+      {
+        damping *= 10.0;
+      }
+    }
+
+    if (!improved || step_norm < 1e-10)
+    {
+      break;
+    }
+  }
+
+  summary.final_cost = cost;
+
+  CalibrationParameters result;
+  result.wheel_radius = parameters[0];
+  result.wheel_separation = parameters[1];
+  result.wheel_base = parameters[2];
+  result.left_wheel_radius_multiplier = parameters[3];
+  result.right_wheel_radius_multiplier = parameters[4];
+  result.steering_angle_correction = parameters[5];
+  return result;
+}
+
+}  // namespace ack_6wd_controller
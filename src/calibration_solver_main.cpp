@@ -0,0 +1,181 @@
+// Copyright 2021 Faiz Pangestu
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Maintainer : Faiz Pangestu
+ *
+ * Batch calibration of the wheel geometry from a recorded drive with ground truth poses.
+ *
+ *   calibration_solver --bag <uri> --ground-truth-topic /mocap/odom
+ *     --left-wheels fl,rl --right-wheels fr,rr --left-steerings sfl,srl --right-steerings sfr,srr
+ *     --wheel-separation 0.6 --wheel-base 0.5 --wheel-radius 0.1 [options] > calibration.yaml
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ack_6wd_controller/calibration_solver.hpp"
+#include "ack_6wd_controller/joint_state_log.hpp"
+#include "ack_6wd_controller/kinematics.hpp"
+#include "ack_6wd_controller/pose_log.hpp"
+
+namespace
+{
+constexpr auto USAGE =
+  "Usage: calibration_solver --bag <uri> --ground-truth-topic <name>\n"
+  "         --left-wheels <names> --right-wheels <names>\n"
+  "         --left-steerings <names> --right-steerings <names>\n"
+  "         --wheel-separation <m> --wheel-base <m> --wheel-radius <m> [options]\n"
+  "\n"
+  "The wheel geometry arguments are the initial guess, ground truth is nav_msgs/Odometry.\n"
+  "\n"
+  "Options:\n"
+  "  --topic <name>                          joint state topic (default /joint_states)\n"
+  "  --left-wheel-radius-multiplier <value>  (default 1.0)\n"
+  "  --right-wheel-radius-multiplier <value> (default 1.0)\n"
+  "  --steering-angle-correction <value>     (default 1.0)\n"
+  "  --velocity-scale <value>                recorded wheel velocity to rad/s (default rpm)\n"
+  "  --window <s>                            ground truth window length (default 1.0)\n"
+  "  --heading-weight <m/rad>                heading residual weight (default 1.0)\n"
+  "  --prior-weight <value>                  pull towards the initial guess (default 1e-6)\n"
+  "  --max-iterations <count>                (default 100)\n"
+  "  --threads <count>                       worker threads (default: all cores)\n";
+
+std::vector<std::string> split(const std::string & list)
+{
+  std::vector<std::string> items;
+  std::stringstream stream(list);
+  std::string item;
+  while (std::getline(stream, item, ','))
+  {
+    if (!item.empty())
+    {
+      items.push_back(item);
+    }
+  }
+  return items;
+}
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  using ack_6wd_controller::CalibrationSolver;
+
+  std::map<std::string, std::string> args;
+  for (int i = 1; i + 1 < argc; i += 2)
+  {
+    const std::string key = argv[i];
+    if (key.compare(0, 2, "--") != 0)
+    {
+      std::cerr << "Unexpected argument '" << key << "'\n" << USAGE;
+      return EXIT_FAILURE;
+    }
+    args[key.substr(2)] = argv[i + 1];
+  }
+
+  const auto get = [&args](const std::string & key, const std::string & default_value) {
+    const auto it = args.find(key);
+    return it != args.end() ? it->second : default_value;
+  };
+
+  const auto left_wheel_names = split(get("left-wheels", ""));
+  const auto right_wheel_names = split(get("right-wheels", ""));
+  const auto left_steering_names = split(get("left-steerings", ""));
+  const auto right_steering_names = split(get("right-steerings", ""));
+  const size_t wheels_per_side = left_wheel_names.size();
+
+  if (
+    get("bag", "").empty() || get("ground-truth-topic", "").empty() || wheels_per_side == 0 ||
+    right_wheel_names.size() != wheels_per_side || left_steering_names.size() != wheels_per_side ||
+    right_steering_names.size() != wheels_per_side || get("wheel-radius", "").empty())
+  {
+    std::cerr << USAGE;
+    return EXIT_FAILURE;
+  }
+
+  // same joint order as make_calibration_samples expects
+  std::vector<std::string> joint_names;
+  for (const auto * names :
+       {&left_wheel_names, &right_wheel_names, &left_steering_names, &right_steering_names})
+  {
+    joint_names.insert(joint_names.end(), names->begin(), names->end());
+  }
+
+  std::string error;
+  ack_6wd_controller::JointStateLog joint_states;
+  if (!ack_6wd_controller::read_joint_state_log(
+        get("bag", ""), get("topic", "/joint_states"), joint_names, joint_states, error))
+  {
+    std::cerr << error << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  ack_6wd_controller::PoseLog ground_truth;
+  if (!ack_6wd_controller::read_pose_log(
+        get("bag", ""), get("ground-truth-topic", ""), ground_truth, error))
+  {
+    std::cerr << error << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  const double velocity_scale = args.count("velocity-scale") ?
+    std::stod(args["velocity-scale"]) : ack_6wd_controller::RPM_TO_RAD_PER_SEC;
+
+  CalibrationSolver::Options options;
+  options.window_duration = std::stod(get("window", "1.0"));
+  options.heading_weight = std::stod(get("heading-weight", "1.0"));
+  options.prior_weight = std::stod(get("prior-weight", "1e-6"));
+  options.max_iterations = std::stoul(get("max-iterations", "100"));
+  options.thread_count = std::stoul(
+    get("threads", std::to_string(std::max(1u, std::thread::hardware_concurrency()))));
+
+  const CalibrationSolver solver(
+    ack_6wd_controller::make_calibration_samples(joint_states, wheels_per_side, velocity_scale),
+    ground_truth, options);
+
+  ack_6wd_controller::CalibrationParameters initial;
+  initial.wheel_radius = std::stod(get("wheel-radius", "0.0"));
+  initial.wheel_separation = std::stod(get("wheel-separation", "0.0"));
+  initial.wheel_base = std::stod(get("wheel-base", "0.0"));
+  initial.left_wheel_radius_multiplier = std::stod(get("left-wheel-radius-multiplier", "1.0"));
+  initial.right_wheel_radius_multiplier = std::stod(get("right-wheel-radius-multiplier", "1.0"));
+  initial.steering_angle_correction = std::stod(get("steering-angle-correction", "1.0"));
+
+  CalibrationSolver::Summary summary;
+  const auto result = solver.solve(initial, summary);
+
+  std::cerr << "Fitted " << summary.window_count << " windows in " << summary.iterations
+            << " iterations, cost " << summary.initial_cost << " -> " << summary.final_cost
+            << std::endl;
+
+  // ready to paste in the controller parameters
+  std::printf(
+    "wheel_radius: %.6f\n"
+    "wheel_separation: %.6f\n"
+    "wheel_base: %.6f\n"
+    "left_wheel_radius_multiplier: %.6f\n"
+    "right_wheel_radius_multiplier: %.6f\n"
+    "steering_angle_correction: %.6f\n",
+    result.wheel_radius, result.wheel_separation, result.wheel_base,
+    result.left_wheel_radius_multiplier, result.right_wheel_radius_multiplier,
+    result.steering_angle_correction);
+  return EXIT_SUCCESS;
+}
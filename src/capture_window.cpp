@@ -0,0 +1,79 @@
+// Copyright 2021 Faiz Pangestu
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Maintainer : Faiz Pangestu
+ */
+
+#include <algorithm>
+
+#include "ack_6wd_controller/capture_window.hpp"
+
+namespace ack_6wd_controller
+{
+void CaptureWindow::configure(size_t pre_cycles, size_t post_cycles)
+{
+  pre_cycles_ = pre_cycles;
+  post_cycles_ = post_cycles;
+  // the pre-trigger window and the triggering record
+  ring_.assign(pre_cycles_ + 1, FlightRecord());
+  reset();
+}
+
+void CaptureWindow::reset()
+{
+  pushed_ = 0;
+  next_ = 0;
+  end_ = 0;
+  capture_count_ = 0;
+}
+
+void CaptureWindow::push(const FlightRecord & record, bool triggered)
+{
+  if (ring_.empty())
+  {
+    return;
+  }
+
+  const uint64_t sequence = pushed_++;
+  ring_[sequence % ring_.size()] = record;
+
+  // pending records about to be overwritten are lost, pop() was not called often enough
+  const uint64_t oldest = pushed_ > ring_.size() ? pushed_ - ring_.size() : 0;
+  next_ = std::max(next_, oldest);
+
+  if (!triggered)
+  {
+    return;
+  }
+
+  if (!isCapturing())
+  {
+    ++capture_count_;
+    // records already handed out by the previous capture are not repeated
+    next_ = std::max(next_, sequence > pre_cycles_ ? sequence - pre_cycles_ : 0);
+  }
+  end_ = std::max(end_, sequence + post_cycles_ + 1);
+}
+
+const FlightRecord * CaptureWindow::pop()
+{
+  if (next_ >= std::min(end_, pushed_))
+  {
+    return nullptr;
+  }
+  return &ring_[next_++ % ring_.size()];
+}
+
+}  // namespace ack_6wd_controller
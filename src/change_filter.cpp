@@ -0,0 +1,86 @@
+// Copyright 2021 Faiz Pangestu
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Maintainer : Faiz Pangestu
+ */
+
+
+#include "ack_6wd_controller/change_filter.hpp"
+
+#include <cmath>
+
+namespace ack_6wd_controller
+{
+constexpr size_t CommandChangeFilter::MAX_JOINTS;
+
+bool CommandChangeFilter::configure(
+  const std::vector<double> & deadbands, size_t refresh_cycles, std::string & error)
+{
+  if (deadbands.size() > MAX_JOINTS)
+  {
+    error = "at most " + std::to_string(MAX_JOINTS) + " joints fit in the mask, got " +
+            std::to_string(deadbands.size());
+    return false;
+  }
+  for (size_t index = 0; index < deadbands.size(); ++index)
+  {
+    if (!(deadbands[index] >= 0.0))
+    {
+      error = "deadband of joint " + std::to_string(index) + " must be >= 0";
+      return false;
+    }
+  }
+
+  deadbands_ = deadbands;
+  sent_.assign(deadbands.size(), 0.0);
+  age_.assign(deadbands.size(), 0);
+  refresh_cycles_ = refresh_cycles;
+  reset();
+  return true;
+}
+
+void CommandChangeFilter::reset()
+{
+  has_sent_ = false;
+  mask_ = 0;
+}
+
+uint32_t CommandChangeFilter::update(double * values)
+{
+  mask_ = 0;
+  for (size_t index = 0; index < deadbands_.size(); ++index)
+  {
+    const double value = values[index];
+    const bool changed = std::isnan(value) != std::isnan(sent_[index]) ||
+                         std::abs(value - sent_[index]) > deadbands_[index] ||
+                         (value == 0.0 && sent_[index] != 0.0);
+    const bool stale = refresh_cycles_ > 0 && age_[index] + 1 >= refresh_cycles_;
+    if (!has_sent_ || changed || stale)
+    {
+      sent_[index] = value;
+      age_[index] = 0;
+      mask_ |= 1u << index;
+    }
+    else
+    {
+      values[index] = sent_[index];
+      ++age_[index];
+    }
+  }
+  has_sent_ = true;
+  return mask_;
+}
+
+}  // namespace ack_6wd_controller
@@ -0,0 +1,143 @@
+// Copyright 2021 Faiz Pangestu
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Maintainer : Faiz Pangestu
+ */
+
+
+#include "ack_6wd_controller/command_mux.hpp"
+
+#include <algorithm>
+
+namespace ack_6wd_controller
+{
+bool CommandMux::configure(const std::vector<Input> & inputs, std::string & error)
+{
+  for (size_t index = 0; index < inputs.size(); ++index)
+  {
+    if (inputs[index].timeout_ns <= 0)
+    {
+      error = "timeout of input " + inputs[index].name + " must be > 0";
+      return false;
+    }
+    for (size_t other = 0; other < index; ++other)
+    {
+      if (inputs[other].name == inputs[index].name)
+      {
+        error = "input " + inputs[index].name + " is given twice";
+        return false;
+      }
+    }
+  }
+
+  inputs_ = inputs;
+  order_.resize(inputs.size());
+  for (size_t index = 0; index < order_.size(); ++index)
+  {
+    order_[index] = index;
+  }
+  // ties go to the input listed first
+  std::stable_sort(order_.begin(), order_.end(), [this](size_t left, size_t right) {
+    return inputs_[left].priority > inputs_[right].priority;
+  });
+  mailboxes_.reset(new Seqlock<MuxCommand>[inputs.size()]);
+  snapshots_.assign(inputs.size(), MuxCommand());
+  newest_stamps_.assign(inputs.size(), 0);
+  duplicates_.reset(new std::atomic<uint64_t>[inputs.size()]);
+  reordered_.reset(new std::atomic<uint64_t>[inputs.size()]);
+  for (size_t index = 0; index < inputs.size(); ++index)
+  {
+    duplicates_[index] = 0;
+    reordered_[index] = 0;
+  }
+  return true;
+}
+
+void CommandMux::setStampCheck(bool enable, int64_t tolerance_ns)
+{
+  check_stamps_ = enable;
+  stamp_tolerance_ns_ = tolerance_ns;
+}
+
+size_t CommandMux::find(const std::string & name) const
+{
+  for (size_t index = 0; index < inputs_.size(); ++index)
+  {
+    if (inputs_[index].name == name)
+    {
+      return index;
+    }
+  }
+  return inputs_.size();
+}
+
+CommandMux::OfferResult CommandMux::offer(
+  size_t index, const MuxCommand & command, int64_t now_ns)
+{
+  int64_t & newest = newest_stamps_[index];
+  const bool held_fresh = newest != 0 && now_ns - newest <= inputs_[index].timeout_ns;
+  if (check_stamps_ && held_fresh && command.stamp_ns <= newest)
+  {
+    if (command.stamp_ns == newest)
+    {
+      duplicates_[index].fetch_add(1, std::memory_order_relaxed);
+      return OFFER_DUPLICATE;
+    }
+    if (newest - command.stamp_ns > stamp_tolerance_ns_)
+    {
+      reordered_[index].fetch_add(1, std::memory_order_relaxed);
+      return OFFER_REORDERED;
+    }
+  }
+
+  // within the tolerance the reference stays the newest stamp seen
+  if (!held_fresh || command.stamp_ns > newest)
+  {
+    newest = command.stamp_ns;
+  }
+  mailboxes_[index].write(command);
+  return OFFER_ACCEPTED;
+}
+
+void CommandMux::clear()
+{
+  for (size_t index = 0; index < inputs_.size(); ++index)
+  {
+    mailboxes_[index].write(MuxCommand());
+    snapshots_[index] = MuxCommand();
+    newest_stamps_[index] = 0;
+  }
+}
+
+size_t CommandMux::select(int64_t now_ns, MuxCommand & command)
+{
+  for (const size_t index : order_)
+  {
+    // keeps the previous command while the writer is in the middle of a new one
+    mailboxes_[index].tryRead(snapshots_[index]);
+    const MuxCommand & candidate = snapshots_[index];
+    if (candidate.stamp_ns != 0 && now_ns - candidate.stamp_ns <= inputs_[index].timeout_ns)
+    {
+      command = candidate;
+      return index;
+    }
+  }
+
+  command = MuxCommand();
+  command.stamp_ns = now_ns;
+  return inputs_.size();
+}
+
+}  // namespace ack_6wd_controller
@@ -0,0 +1,134 @@
+// Copyright 2021 Faiz Pangestu
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Maintainer : Faiz Pangestu
+ */
+
+
+#include "ack_6wd_controller/command_predictor.hpp"
+
+#include <algorithm>
+
+namespace ack_6wd_controller
+{
+namespace
+{
+// value at t of the polynomial through the samples, times relative to the newest one [s]
+double extrapolate(const double * times, const double * values, size_t count, double t)
+{
+  // Lagrange form, count is at most 3
+  double result = 0.0;
+  for (size_t i = 0; i < count; ++i)
+  {
+    double weight = 1.0;
+    for (size_t j = 0; j < count; ++j)
+    {
+      if (j != i)
+      {
+        weight *= (t - times[j]) / (times[i] - times[j]);
+      }
+    }
+    result += weight * values[i];
+  }
+  return result;
+}
+
+// keeps the prediction on the side of zero of the last command
+double same_sign(double prediction, double last)
+{
+  if (last > 0.0)
+  {
+    return std::max(prediction, 0.0);
+  }
+  if (last < 0.0)
+  {
+    return std::min(prediction, 0.0);
+  }
+  return 0.0;
+}
+}  // namespace
+
+constexpr size_t CommandPredictor::MAX_ORDER;
+
+void CommandPredictor::configure(size_t order, double max_gap, double horizon)
+{
+  order_ = std::min(order, MAX_ORDER);
+  max_gap_ns_ = static_cast<int64_t>(max_gap * 1e9);
+  horizon_ns_ = static_cast<int64_t>(horizon * 1e9);
+  reset();
+}
+
+void CommandPredictor::reset()
+{
+  count_ = 0;
+}
+
+void CommandPredictor::add(int64_t stamp_ns, double linear, double angular)
+{
+  if (count_ > 0 && stamp_ns <= stamps_[0])
+  {
+    return;
+  }
+
+  for (size_t index = std::min(count_, MAX_ORDER); index > 0; --index)
+  {
+    stamps_[index] = stamps_[index - 1];
+    linear_[index] = linear_[index - 1];
+    angular_[index] = angular_[index - 1];
+  }
+  stamps_[0] = stamp_ns;
+  linear_[0] = linear;
+  angular_[0] = angular;
+  count_ = std::min(count_ + 1, MAX_ORDER + 1);
+}
+
+void CommandPredictor::predict(int64_t now_ns, double & linear, double & angular) const
+{
+  if (count_ == 0)
+  {
+    linear = 0.0;
+    angular = 0.0;
+    return;
+  }
+
+  linear = linear_[0];
+  angular = angular_[0];
+  const int64_t age_ns = std::max(now_ns - stamps_[0], int64_t(0));
+  if (order_ == 0 || count_ < order_ + 1 || age_ns > horizon_ns_)
+  {
+    return;
+  }
+
+  // hold when the commands are too sparse to tell the trend
+  for (size_t index = 1; index <= order_; ++index)
+  {
+    if (stamps_[index - 1] - stamps_[index] > max_gap_ns_)
+    {
+      return;
+    }
+  }
+
+  double times[MAX_ORDER + 1];
+  for (size_t index = 0; index <= order_; ++index)
+  {
+    times[index] = static_cast<double>(stamps_[index] - stamps_[0]) * 1e-9;
+  }
+  const double t = static_cast<double>(age_ns) * 1e-9;
+
+  linear = same_sign(extrapolate(times, linear_.data(), order_ + 1, t), linear_[0]);
+  angular = same_sign(extrapolate(times, angular_.data(), order_ + 1, t), angular_[0]);
+}
+
+}  // namespace ack_6wd_controller
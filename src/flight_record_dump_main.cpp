@@ -0,0 +1,96 @@
+// Copyright 2021 Faiz Pangestu
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Maintainer : Faiz Pangestu
+ *
+ * Print a flight record dumped by the controller as CSV.
+ *
+ *   flight_record_dump <file> > record.csv
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "ack_6wd_controller/flight_recorder.hpp"
+
+namespace
+{
+const char * reason_name(uint32_t reason)
+{
+  using ack_6wd_controller::FlightRecorder;
+  switch (reason)
+  {
+    case FlightRecorder::DUMP_ON_ERROR:
+      return "error";
+    case FlightRecorder::DUMP_ON_DEADLINE_MISS:
+      return "deadline miss";
+    case FlightRecorder::DUMP_ON_REQUEST:
+      return "request";
+    default:
+      return "unknown";
+  }
+}
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  if (argc != 2)
+  {
+    std::cerr << "Usage: flight_record_dump <file>" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  ack_6wd_controller::FlightRecordHeader header;
+  std::vector<ack_6wd_controller::FlightRecord> records;
+  std::string error;
+  if (!ack_6wd_controller::read_flight_record(argv[1], header, records, error))
+  {
+    std::cerr << error << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  const size_t joint_count = records.empty() ? 0 : records.back().joint_count;
+  std::printf(
+    "stamp,period,execution_time,result,events,command_linear,command_angular,limited_linear,"
+    "limited_angular,odometry_x,odometry_y,odometry_heading,odometry_linear,odometry_angular");
+  for (size_t joint = 0; joint < joint_count; ++joint)
+  {
+    std::printf(",position_%zu,velocity_%zu,command_%zu", joint, joint, joint);
+  }
+  std::printf("\n");
+
+  for (const auto & record : records)
+  {
+    std::printf(
+      "%.9f,%.6f,%.6f,%d,%u,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f", record.stamp_ns * 1e-9,
+      record.period, record.execution_time, record.result, record.events, record.command_linear,
+      record.command_angular, record.limited_linear, record.limited_angular, record.odometry_x,
+      record.odometry_y, record.odometry_heading, record.odometry_linear, record.odometry_angular);
+    for (size_t joint = 0; joint < joint_count; ++joint)
+    {
+      std::printf(
+        ",%.6f,%.6f,%.6f", record.joint_positions[joint], record.joint_velocities[joint],
+        record.joint_commands[joint]);
+    }
+    std::printf("\n");
+  }
+
+  std::cerr << "Dump " << header.sequence << " on " << reason_name(header.reason) << " at "
+            << header.dump_stamp_ns * 1e-9 << ", " << records.size() << " cycles" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,199 @@
+// Copyright 2021 Faiz Pangestu
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Maintainer : Faiz Pangestu
+ */
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+
+#include "ack_6wd_controller/flight_recorder.hpp"
+
+namespace
+{
+constexpr char MAGIC[8] = {'A', 'C', 'K', 'F', 'R', 'E', 'C', '\0'};
+constexpr uint32_t VERSION = 2;
+}  // namespace
+
+namespace ack_6wd_controller
+{
+FlightRecorder::~FlightRecorder()
+{
+  release();
+}
+
+bool FlightRecorder::configure(const std::string & path, size_t capacity, std::string & error)
+{
+  release();
+
+  if (capacity == 0)
+  {
+    error = "Flight recorder capacity must be > 0";
+    return false;
+  }
+
+  ring_.assign(capacity, FlightRecord());
+  head_ = 0;
+  count_ = 0;
+  current_ = FlightRecord();
+  sequence_ = 0;
+
+  file_descriptor_ = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (file_descriptor_ < 0)
+  {
+    error = "Unable to open '" + path + "': " + strerror(errno);
+    release();
+    return false;
+  }
+
+  mapping_size_ = sizeof(FlightRecordHeader) + capacity * sizeof(FlightRecord);
+  if (ftruncate(file_descriptor_, static_cast<off_t>(mapping_size_)) != 0)
+  {
+    error = "Unable to size '" + path + "': " + strerror(errno);
+    release();
+    return false;
+  }
+
+  void * mapping =
+    mmap(nullptr, mapping_size_, PROT_READ | PROT_WRITE, MAP_SHARED, file_descriptor_, 0);
+  if (mapping == MAP_FAILED)
+  {
+    error = "Unable to map '" + path + "': " + strerror(errno);
+    release();
+    return false;
+  }
+  mapping_ = mapping;
+
+  // touch every page now so the first dump does not fault them in from the control loop
+  std::memset(mapping_, 0, mapping_size_);
+  return true;
+}
+
+void FlightRecorder::release()
+{
+  if (mapping_ != nullptr)
+  {
+    munmap(mapping_, mapping_size_);
+    mapping_ = nullptr;
+  }
+  mapping_size_ = 0;
+  if (file_descriptor_ >= 0)
+  {
+    close(file_descriptor_);
+    file_descriptor_ = -1;
+  }
+  ring_.clear();
+  ring_.shrink_to_fit();
+  head_ = 0;
+  count_ = 0;
+}
+
+void FlightRecorder::begin()
+{
+  current_ = FlightRecord();
+}
+
+void FlightRecorder::commit()
+{
+  if (ring_.empty())
+  {
+    return;
+  }
+  ring_[head_] = current_;
+  head_ = (head_ + 1) % ring_.size();
+  if (count_ < ring_.size())
+  {
+    ++count_;
+  }
+}
+
+void FlightRecorder::dump(DumpReason reason, int64_t stamp_ns)
+{
+  if (mapping_ == nullptr)
+  {
+    return;
+  }
+
+  auto * header = static_cast<FlightRecordHeader *>(mapping_);
+  auto * records = reinterpret_cast<FlightRecord *>(header + 1);
+
+  // a reader seeing record_count 0 knows the dump is in progress
+  header->record_count = 0;
+
+  // oldest records first, they start at head once the ring has wrapped
+  const size_t oldest = count_ < ring_.size() ? 0 : head_;
+  const size_t first_part = std::min(count_, ring_.size() - oldest);
+  std::memcpy(records, &ring_[oldest], first_part * sizeof(FlightRecord));
+  std::memcpy(records + first_part, ring_.data(), (count_ - first_part) * sizeof(FlightRecord));
+
+  std::memcpy(header->magic, MAGIC, sizeof(MAGIC));
+  header->version = VERSION;
+  header->record_size = sizeof(FlightRecord);
+  header->capacity = ring_.size();
+  header->dump_stamp_ns = stamp_ns;
+  header->reason = reason;
+  header->sequence = ++sequence_;
+  header->record_count = count_;
+
+  // schedule the write back, the kernel does it outside of the control loop
+  msync(mapping_, mapping_size_, MS_ASYNC);
+}
+
+bool read_flight_record(
+  const std::string & path, FlightRecordHeader & header, std::vector<FlightRecord> & records,
+  std::string & error)
+{
+  std::ifstream file(path, std::ios::binary);
+  if (!file)
+  {
+    error = "Unable to open '" + path + "'";
+    return false;
+  }
+
+  if (!file.read(reinterpret_cast<char *>(&header), sizeof(header)))
+  {
+    error = "'" + path + "' is too short for a flight record";
+    return false;
+  }
+  if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0)
+  {
+    error = "'" + path + "' is not a flight record, or nothing was dumped yet";
+    return false;
+  }
+  if (header.version != VERSION || header.record_size != sizeof(FlightRecord))
+  {
+    error = "'" + path + "' was written by an incompatible version";
+    return false;
+  }
+
+  records.resize(header.record_count);
+  if (!file.read(
+        reinterpret_cast<char *>(records.data()),
+        static_cast<std::streamsize>(records.size() * sizeof(FlightRecord))))
+  {
+    error = "'" + path + "' is truncated";
+    return false;
+  }
+  return true;
+}
+
+}  // namespace ack_6wd_controller
@@ -0,0 +1,73 @@
+// Copyright 2021 Faiz Pangestu
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Maintainer : Faiz Pangestu
+ */
+
+#include "ack_6wd_controller/interface_registry.hpp"
+
+namespace ack_6wd_controller
+{
+InterfaceRegistry & InterfaceRegistry::instance()
+{
+  static InterfaceRegistry registry;
+  return registry;
+}
+
+InterfaceRegistry::InterfacePtr InterfaceRegistry::exportInterface(
+  const std::string & name, double value, std::string & error)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (interfaces_.count(name) != 0)
+  {
+    error = "interface " + name + " is exported already";
+    return nullptr;
+  }
+  auto exported = std::make_shared<ExportedInterface>(value);
+  if (!exported->isLockFree())
+  {
+    error = "interface " + name + " can not be exported, doubles are not lock-free atomics here";
+    return nullptr;
+  }
+  interfaces_.emplace(name, exported);
+  return exported;
+}
+
+void InterfaceRegistry::unexportInterface(const std::string & name)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  interfaces_.erase(name);
+}
+
+InterfaceRegistry::InterfacePtr InterfaceRegistry::findInterface(const std::string & name) const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto it = interfaces_.find(name);
+  return it == interfaces_.end() ? nullptr : it->second;
+}
+
+std::vector<std::string> InterfaceRegistry::getNames() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<std::string> names;
+  names.reserve(interfaces_.size());
+  for (const auto & entry : interfaces_)
+  {
+    names.push_back(entry.first);
+  }
+  return names;
+}
+
+}  // namespace ack_6wd_controller
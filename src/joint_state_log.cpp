@@ -0,0 +1,191 @@
+// Copyright 2021 Faiz Pangestu
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Maintainer : Faiz Pangestu
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ack_6wd_controller/joint_state_log.hpp"
+#include "ack_6wd_controller/telemetry_log.hpp"
+#include "rclcpp/serialization.hpp"
+#include "rclcpp/serialized_message.hpp"
+#include "rosbag2_cpp/converter_options.hpp"
+#include "rosbag2_cpp/readers/sequential_reader.hpp"
+#include "rosbag2_storage/storage_options.hpp"
+#include "sensor_msgs/msg/joint_state.hpp"
+
+namespace ack_6wd_controller
+{
+bool read_joint_state_log(
+  const std::string & uri, const std::string & topic,
+  const std::vector<std::string> & joint_names, JointStateLog & log, std::string & error)
+{
+  log = JointStateLog();
+  log.joint_names = joint_names;
+
+  rosbag2_cpp::readers::SequentialReader reader;
+  try
+  {
+    rosbag2_storage::StorageOptions storage_options;
+    storage_options.uri = uri;
+    storage_options.storage_id = "sqlite3";
+
+    rosbag2_cpp::ConverterOptions converter_options;
+    converter_options.input_serialization_format = "cdr";
+    converter_options.output_serialization_format = "cdr";
+
+    reader.open(storage_options, converter_options);
+  }
+  catch (const std::exception & e)
+  {
+    error = "Unable to open bag '" + uri + "': " + e.what();
+    return false;
+  }
+
+  rclcpp::Serialization<sensor_msgs::msg::JointState> serialization;
+  sensor_msgs::msg::JointState msg;
+
+  // index of each requested joint in the message, recomputed when the name list changes
+  std::vector<std::string> cached_names;
+  std::vector<size_t> joint_indices(joint_names.size());
+  bool indices_valid = false;
+
+  while (reader.has_next())
+  {
+    const auto bag_message = reader.read_next();
+    if (bag_message->topic_name != topic)
+    {
+      continue;
+    }
+
+    rclcpp::SerializedMessage serialized_msg(*bag_message->serialized_data);
+    serialization.deserialize_message(&serialized_msg, &msg);
+
+    if (msg.name != cached_names)
+    {
+      cached_names = msg.name;
+      indices_valid = true;
+      for (size_t i = 0; i < joint_names.size(); ++i)
+      {
+        const auto it = std::find(msg.name.begin(), msg.name.end(), joint_names[i]);
+        if (it == msg.name.end())
+        {
+          indices_valid = false;
+          break;
+        }
+        joint_indices[i] = static_cast<size_t>(it - msg.name.begin());
+      }
+    }
+
+    if (!indices_valid)
+    {
+      continue;
+    }
+
+    // fall back to the recording time for unstamped states
+    if (msg.header.stamp.sec == 0 && msg.header.stamp.nanosec == 0)
+    {
+      log.stamps.emplace_back(bag_message->time_stamp);
+    }
+    else
+    {
+      log.stamps.emplace_back(msg.header.stamp);
+    }
+
+    for (const size_t index : joint_indices)
+    {
+      log.positions.push_back(index < msg.position.size() ? msg.position[index] : NAN);
+      log.velocities.push_back(index < msg.velocity.size() ? msg.velocity[index] : NAN);
+    }
+  }
+
+  if (log.size() == 0)
+  {
+    error = "No joint states with all the requested joints on topic '" + topic + "'";
+    return false;
+  }
+
+  return true;
+}
+
+bool read_joint_state_telemetry(
+  const std::string & path, const std::vector<std::string> & joint_names, JointStateLog & log,
+  std::string & error)
+{
+  log = JointStateLog();
+  log.joint_names = joint_names;
+
+  TelemetryReader reader;
+  if (!reader.open(path, error))
+  {
+    return false;
+  }
+
+  std::vector<int64_t> stamps;
+  if (!reader.read_stamps(stamps, error))
+  {
+    return false;
+  }
+  if (stamps.empty())
+  {
+    error = "No samples in '" + path + "'";
+    return false;
+  }
+
+  const size_t joint_count = joint_names.size();
+  log.positions.resize(stamps.size() * joint_count);
+  log.velocities.resize(stamps.size() * joint_count);
+
+  // only the requested columns are decoded
+  std::vector<double> column;
+  for (size_t joint = 0; joint < joint_count; ++joint)
+  {
+    for (const bool is_position : {true, false})
+    {
+      const std::string name = joint_names[joint] + (is_position ? "/position" : "/velocity");
+      const size_t index = reader.find(name);
+      if (index == reader.columns().size())
+      {
+        error = "No column '" + name + "' in '" + path + "'";
+        return false;
+      }
+      if (!reader.read_column(index, column, error))
+      {
+        return false;
+      }
+
+      auto & values = is_position ? log.positions : log.velocities;
+      for (size_t row = 0; row < stamps.size(); ++row)
+      {
+        values[row * joint_count + joint] = column[row];
+      }
+    }
+  }
+
+  log.stamps.reserve(stamps.size());
+  for (const int64_t stamp : stamps)
+  {
+    log.stamps.emplace_back(stamp);
+  }
+  return true;
+}
+
+}  // namespace ack_6wd_controller
@@ -0,0 +1,98 @@
+// Copyright 2021 Faiz Pangestu
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Maintainer : Faiz Pangestu
+ */
+
+
+#include "ack_6wd_controller/joint_transform.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ack_6wd_controller
+{
+bool JointTransformTable::configure(
+  const std::vector<JointTransform> & transforms, std::string & error)
+{
+  for (size_t index = 0; index < transforms.size(); ++index)
+  {
+    const auto & transform = transforms[index];
+    if (!std::isfinite(transform.scale) || transform.scale == 0.0)
+    {
+      error = "scale of joint " + std::to_string(index) + " must be finite and non zero";
+      return false;
+    }
+    if (transform.sign != 1.0 && transform.sign != -1.0)
+    {
+      error = "sign of joint " + std::to_string(index) + " must be 1 or -1";
+      return false;
+    }
+    if (!std::isfinite(transform.offset))
+    {
+      error = "offset of joint " + std::to_string(index) + " must be finite";
+      return false;
+    }
+    if (!(transform.lower_limit <= transform.upper_limit))
+    {
+      error = "lower limit of joint " + std::to_string(index) + " is above its upper limit";
+      return false;
+    }
+  }
+
+  const size_t count = transforms.size();
+  gains_.resize(count);
+  inverse_gains_.resize(count);
+  offsets_.resize(count);
+  lower_limits_.resize(count);
+  upper_limits_.resize(count);
+  for (size_t index = 0; index < count; ++index)
+  {
+    const auto & transform = transforms[index];
+    gains_[index] = transform.sign * transform.scale;
+    inverse_gains_[index] = 1.0 / gains_[index];
+    offsets_[index] = transform.offset;
+    lower_limits_[index] = transform.lower_limit;
+    upper_limits_[index] = transform.upper_limit;
+  }
+  return true;
+}
+
+void JointTransformTable::apply(const double * values, double * outputs) const
+{
+  const size_t count = gains_.size();
+  const double * gains = gains_.data();
+  const double * offsets = offsets_.data();
+  const double * lower_limits = lower_limits_.data();
+  const double * upper_limits = upper_limits_.data();
+  for (size_t index = 0; index < count; ++index)
+  {
+    const double output = gains[index] * values[index] + offsets[index];
+    outputs[index] = std::min(std::max(output, lower_limits[index]), upper_limits[index]);
+  }
+}
+
+void JointTransformTable::invert(const double * values, double * outputs) const
+{
+  const size_t count = gains_.size();
+  const double * inverse_gains = inverse_gains_.data();
+  const double * offsets = offsets_.data();
+  for (size_t index = 0; index < count; ++index)
+  {
+    outputs[index] = (values[index] - offsets[index]) * inverse_gains[index];
+  }
+}
+
+}  // namespace ack_6wd_controller
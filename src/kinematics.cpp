@@ -0,0 +1,163 @@
+// Copyright 2021 Faiz Pangestu
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Maintainer : Faiz Pangestu
+ */
+
+#define _USE_MATH_DEFINES
+#include <cmath>
+
+#include <algorithm>
+
+#include "ack_6wd_controller/kinematics.hpp"
+
+namespace ack_6wd_controller
+{
+int quadrant(double linear, double angular)
+{
+  if (linear > 0) {
+    if (angular >= 0) {
+      return 0;
+    } else {
+      return 1;
+    }
+  } else {
+    if (angular > 0) {
+      return 2;
+    } else {
+      return 3;
+    }
+  }
+}
+
+void fuse_wheel_states(
+  const double * left_velocities, const double * right_velocities, const double * left_angles,
+  const double * right_angles, size_t wheels_per_side, double & angle, double & velocity)
+{
+  double left_velocity_mean = 0.0;
+  double right_velocity_mean = 0.0;
+  double left_angle_mean = 0.0;
+  double right_angle_mean = 0.0;
+  for (size_t index = 0; index < wheels_per_side; ++index)
+  {
+    left_velocity_mean += std::abs(left_velocities[index]);
+    right_velocity_mean += std::abs(right_velocities[index]);
+
+    left_angle_mean += std::abs(left_angles[index]);
+    right_angle_mean += std::abs(right_angles[index]);
+  }
+
+  left_velocity_mean = left_velocity_mean/wheels_per_side;
+  right_velocity_mean = right_velocity_mean/wheels_per_side;
+  left_angle_mean = left_angle_mean/wheels_per_side;
+  right_angle_mean = right_angle_mean/wheels_per_side;
+
+  const int q = quadrant(left_velocities[0], left_angles[0]);
+
+  velocity = std::min(left_velocity_mean, right_velocity_mean) * (q == 0 || q == 1 ? 1 : -1);
+  angle = std::max(left_angle_mean, right_angle_mean) * (q == 0 || q == 2 ? 1 : -1);
+}
+
+bool fit_base_displacement(
+  const double * distances, const double * angles, const double * x, const double * y,
+  size_t count, double & linear, double & angular)
+{
+  // normal equations of the 2 unknowns
+  double aa = 0.0;
+  double ab = 0.0;
+  double bb = 0.0;
+  double ad = 0.0;
+  double bd = 0.0;
+  for (size_t index = 0; index < count; ++index)
+  {
+    const double a = cos(angles[index]);
+    const double b = x[index] * sin(angles[index]) - y[index] * a;
+    aa += a * a;
+    ab += a * b;
+    bb += b * b;
+    ad += a * distances[index];
+    bd += b * distances[index];
+  }
+
+  const double determinant = aa * bb - ab * ab;
+  if (!(determinant > 1e-12))
+  {
+    return false;
+  }
+  linear = (bb * ad - ab * bd) / determinant;
+  angular = (aa * bd - ab * ad) / determinant;
+  return true;
+}
+
+void wheel_speed_ratios(
+  double angle, double wheel_base, double wheel_separation, double & steered_outer,
+  double & middle_inner, double & middle_outer)
+{
+  angle = std::abs(angle);
+  if (angle < 1e-6)
+  {
+    steered_outer = 1.0;
+    middle_inner = 1.0;
+    middle_outer = 1.0;
+    return;
+  }
+
+  // turning radius giving this inner angle, then the distances used by the inverse kinematics
+  const double turning_radius = wheel_base / 2 + (wheel_separation / 2) / tan(angle);
+  const double angle_outer = M_PI/2 - atan((2*turning_radius + wheel_base) / wheel_separation);
+
+  const double inner_axis = wheel_separation / (2 * sin(angle));
+  const double outer_axis = wheel_separation / (2 * sin(angle_outer));
+
+  steered_outer = outer_axis / inner_axis;
+  middle_inner = std::abs(turning_radius - wheel_base) / inner_axis;
+  middle_outer = (turning_radius + wheel_base) / inner_axis;
+}
+
+double minimum_turning_radius(
+  double wheel_base, double wheel_separation, double max_steering_angle)
+{
+  // the inner angle of the inverse kinematics, atan(wheel_separation / (2 * R - wheel_base))
+  return wheel_base / 2 + (wheel_separation / 2) / tan(max_steering_angle);
+}
+
+bool project_feasible_command(
+  double min_radius, FeasibilityPolicy policy, double & linear, double & angular)
+{
+  // no geometry to project onto, e.g. wheel_base and wheel_separation left at 0
+  if (!(min_radius > 0.0))
+  {
+    return false;
+  }
+
+  const double max_angular = std::abs(linear) / min_radius;
+  if (std::abs(angular) <= max_angular)
+  {
+    return false;
+  }
+
+  if (policy == PRESERVE_CURVATURE)
+  {
+    const double speed = std::abs(angular) * min_radius;
+    linear = linear < 0.0 ? -speed : speed;
+  }
+  else
+  {
+    angular = angular < 0.0 ? -max_angular : max_angular;
+  }
+  return true;
+}
+
+}  // namespace ack_6wd_controller
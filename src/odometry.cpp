@@ -34,8 +34,6 @@ Odometry::Odometry(size_t velocity_rolling_window_size)
   wheel_base_(0.0),
   left_wheel_radius_(0.0),
   right_wheel_radius_(0.0),
-  left_wheel_old_pos_(0.0),
-  right_wheel_old_pos_(0.0),
   velocity_rolling_window_size_(velocity_rolling_window_size),
   linear_accumulator_(velocity_rolling_window_size),
   angular_accumulator_(velocity_rolling_window_size)
@@ -75,43 +73,22 @@ void Odometry::updateVel(double angle, double velocity, const rclcpp::Time & tim
   debug_ = linear_;
 }
 
-bool Odometry::update(double left_pos, double right_pos, const rclcpp::Time & time)
+bool Odometry::updateDisplacement(double linear, double angular, const rclcpp::Time & time)
 {
   // We cannot estimate the speed with very small time intervals:
   const double dt = time.seconds() - timestamp_.seconds();
   if (dt < 0.0001)
   {
-    return false;  // Interval too small to integrate with
+    return false;  // Interval too small to integrate with, the caller keeps the displacement
   }
-
-  // Get current wheel joint positions:
-  const double left_wheel_cur_pos = left_pos * left_wheel_radius_;
-  const double right_wheel_cur_pos = right_pos * right_wheel_radius_;
-
-  // Estimate velocity of wheels using old and current position:
-  const double left_wheel_est_vel = left_wheel_cur_pos - left_wheel_old_pos_;
-  const double right_wheel_est_vel = right_wheel_cur_pos - right_wheel_old_pos_;
-
-  // Update old position with current:
-  left_wheel_old_pos_ = left_wheel_cur_pos;
-  right_wheel_old_pos_ = right_wheel_cur_pos;
-
-  // Compute linear and angular diff:
-  const double linear = (right_wheel_est_vel + left_wheel_est_vel) * 0.5;
-  // Now there is a bug about scout angular velocity
-  const double angular = (right_wheel_est_vel - left_wheel_est_vel) / wheel_separation_;
+  timestamp_ = time;
 
   // Integrate odometry:
   integrateExact(linear, angular);
 
-  timestamp_ = time;
-
-  // Estimate speeds using a rolling mean to filter them out:
-  linear_accumulator_.accumulate(linear / dt);
-  angular_accumulator_.accumulate(angular / dt);
-
-  linear_ = linear_accumulator_.getRollingMean();
-  angular_ = angular_accumulator_.getRollingMean();
+  // Positions are exact, their difference needs no filtering
+  linear_ = linear / dt;
+  angular_ = angular / dt;
 
   return true;
 }
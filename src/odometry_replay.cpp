@@ -0,0 +1,152 @@
+// Copyright 2021 Faiz Pangestu
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Maintainer : Faiz Pangestu
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "ack_6wd_controller/kinematics.hpp"
+#include "ack_6wd_controller/odometry.hpp"
+#include "ack_6wd_controller/odometry_replay.hpp"
+#include "ack_6wd_controller/parallel_for.hpp"
+
+namespace ack_6wd_controller
+{
+Pose2D compose(const Pose2D & a, const Pose2D & b)
+{
+  Pose2D result;
+  result.x = a.x + cos(a.heading) * b.x - sin(a.heading) * b.y;
+  result.y = a.y + sin(a.heading) * b.x + cos(a.heading) * b.y;
+  result.heading = a.heading + b.heading;
+  return result;
+}
+
+std::vector<OdometrySample> fuse_joint_state_log(
+  const JointStateLog & log, size_t wheels_per_side, double velocity_scale)
+{
+  std::vector<OdometrySample> samples;
+  samples.reserve(log.size());
+
+  std::vector<double> left_velocities(wheels_per_side);
+  std::vector<double> right_velocities(wheels_per_side);
+  for (size_t row = 0; row < log.size(); ++row)
+  {
+    const double * velocities = log.velocity_row(row);
+    const double * positions = log.position_row(row);
+    const double * left_angles = positions + 2 * wheels_per_side;
+    const double * right_angles = positions + 3 * wheels_per_side;
+
+    bool valid = true;
+    for (size_t index = 0; index < wheels_per_side; ++index)
+    {
+      left_velocities[index] = velocities[index] * velocity_scale;
+      right_velocities[index] = velocities[wheels_per_side + index] * velocity_scale;
+
+      valid &= !std::isnan(left_velocities[index]) && !std::isnan(right_velocities[index]) &&
+               !std::isnan(left_angles[index]) && !std::isnan(right_angles[index]);
+    }
+    if (!valid)
+    {
+      continue;
+    }
+
+    OdometrySample sample{log.stamps[row], 0.0, 0.0};
+    fuse_wheel_states(
+      left_velocities.data(), right_velocities.data(), left_angles, right_angles, wheels_per_side,
+      sample.angle, sample.velocity);
+    samples.push_back(sample);
+  }
+
+  return samples;
+}
+
+OdometryReplay::OdometryReplay(
+  double wheel_separation, double wheel_base, double left_wheel_radius, double right_wheel_radius)
+: wheel_separation_(wheel_separation),
+  wheel_base_(wheel_base),
+  left_wheel_radius_(left_wheel_radius),
+  right_wheel_radius_(right_wheel_radius)
+{
+}
+
+std::vector<Pose2D> OdometryReplay::run(
+  const std::vector<OdometrySample> & samples, size_t segment_size, size_t thread_count) const
+{
+  std::vector<Pose2D> trajectory(samples.size());
+  if (samples.empty())
+  {
+    return trajectory;
+  }
+
+  segment_size = std::max<size_t>(1, segment_size);
+  const size_t segment_count = (samples.size() + segment_size - 1) / segment_size;
+
+  // Odometry skips samples too close to the last integrated one, so a segment has to start
+  // from the stamp a sequential run would hold at that point. Only stamps are needed for that.
+  std::vector<rclcpp::Time> segment_start_stamps(segment_count, samples.front().stamp);
+  rclcpp::Time last_integrated = samples.front().stamp;
+  for (size_t index = 0; index < samples.size(); ++index)
+  {
+    if (index % segment_size == 0)
+    {
+      segment_start_stamps[index / segment_size] = last_integrated;
+    }
+    if (samples[index].stamp.seconds() - last_integrated.seconds() >= 0.0001)
+    {
+      last_integrated = samples[index].stamp;
+    }
+  }
+
+  // integrate every segment from the origin
+  parallel_for(segment_count, thread_count, [&](size_t segment) {
+    Odometry odometry;
+    odometry.setWheelParams(
+      wheel_separation_, wheel_base_, left_wheel_radius_, right_wheel_radius_);
+    odometry.init(segment_start_stamps[segment]);
+
+    const size_t end = std::min(samples.size(), (segment + 1) * segment_size);
+    for (size_t index = segment * segment_size; index < end; ++index)
+    {
+      odometry.updateVel(samples[index].angle, samples[index].velocity, samples[index].stamp);
+      trajectory[index].x = odometry.getX();
+      trajectory[index].y = odometry.getY();
+      trajectory[index].heading = odometry.getHeading();
+    }
+  });
+
+  // chain the segment origins, then move every segment into the common frame
+  std::vector<Pose2D> segment_origins(segment_count);
+  for (size_t segment = 1; segment < segment_count; ++segment)
+  {
+    segment_origins[segment] =
+      compose(segment_origins[segment - 1], trajectory[segment * segment_size - 1]);
+  }
+
+  parallel_for(segment_count - 1, thread_count, [&](size_t index) {
+    const size_t segment = index + 1;
+    const size_t end = std::min(samples.size(), (segment + 1) * segment_size);
+    for (size_t i = segment * segment_size; i < end; ++i)
+    {
+      trajectory[i] = compose(segment_origins[segment], trajectory[i]);
+    }
+  });
+
+  return trajectory;
+}
+
+}  // namespace ack_6wd_controller
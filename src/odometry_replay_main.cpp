@@ -0,0 +1,177 @@
+// Copyright 2021 Faiz Pangestu
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Maintainer : Faiz Pangestu
+ *
+ * Offline reconstruction of the controller odometry from recorded joint states.
+ *
+ *   odometry_replay --bag <uri> --left-wheels fl,rl --right-wheels fr,rr
+ *     --left-steerings sfl,srl --right-steerings sfr,srr
+ *     --wheel-separation 0.6 --wheel-base 0.5 --wheel-radius 0.1 [options] > odom.csv
+ *
+ * A controller telemetry log can be replayed instead of a bag with --telemetry <file>.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ack_6wd_controller/joint_state_log.hpp"
+#include "ack_6wd_controller/kinematics.hpp"
+#include "ack_6wd_controller/odometry_replay.hpp"
+
+namespace
+{
+constexpr auto USAGE =
+  "Usage: odometry_replay (--bag <uri> | --telemetry <file>)\n"
+  "         --left-wheels <names> --right-wheels <names>\n"
+  "         --left-steerings <names> --right-steerings <names>\n"
+  "         --wheel-separation <m> --wheel-base <m> --wheel-radius <m> [options]\n"
+  "\n"
+  "Options:\n"
+  "  --topic <name>                         joint state topic (default /joint_states)\n"
+  "  --wheel-separation-multiplier <value>  (default 1.0)\n"
+  "  --wheel-base-multiplier <value>        (default 1.0)\n"
+  "  --left-wheel-radius-multiplier <value> (default 1.0)\n"
+  "  --right-wheel-radius-multiplier <value> (default 1.0)\n"
+  "  --velocity-scale <value>               recorded wheel velocity to rad/s (default rpm)\n"
+  "  --segment-size <samples>               samples integrated per task (default 20000)\n"
+  "  --threads <count>                      worker threads (default: all cores)\n"
+  "  --output <file>                        CSV output (default stdout)\n";
+
+std::vector<std::string> split(const std::string & list)
+{
+  std::vector<std::string> items;
+  std::stringstream stream(list);
+  std::string item;
+  while (std::getline(stream, item, ','))
+  {
+    if (!item.empty())
+    {
+      items.push_back(item);
+    }
+  }
+  return items;
+}
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  using ack_6wd_controller::OdometryReplay;
+
+  std::map<std::string, std::string> args;
+  for (int i = 1; i + 1 < argc; i += 2)
+  {
+    const std::string key = argv[i];
+    if (key.compare(0, 2, "--") != 0)
+    {
+      std::cerr << "Unexpected argument '" << key << "'\n" << USAGE;
+      return EXIT_FAILURE;
+    }
+    args[key.substr(2)] = argv[i + 1];
+  }
+
+  const auto get = [&args](const std::string & key, const std::string & default_value) {
+    const auto it = args.find(key);
+    return it != args.end() ? it->second : default_value;
+  };
+
+  const auto left_wheel_names = split(get("left-wheels", ""));
+  const auto right_wheel_names = split(get("right-wheels", ""));
+  const auto left_steering_names = split(get("left-steerings", ""));
+  const auto right_steering_names = split(get("right-steerings", ""));
+  const size_t wheels_per_side = left_wheel_names.size();
+
+  if (
+    get("bag", "").empty() == get("telemetry", "").empty() || wheels_per_side == 0 ||
+    right_wheel_names.size() != wheels_per_side || left_steering_names.size() != wheels_per_side ||
+    right_steering_names.size() != wheels_per_side || get("wheel-radius", "").empty())
+  {
+    std::cerr << USAGE;
+    return EXIT_FAILURE;
+  }
+
+  // same joint order as fuse_joint_state_log expects
+  std::vector<std::string> joint_names;
+  for (const auto * names :
+       {&left_wheel_names, &right_wheel_names, &left_steering_names, &right_steering_names})
+  {
+    joint_names.insert(joint_names.end(), names->begin(), names->end());
+  }
+
+  ack_6wd_controller::JointStateLog log;
+  std::string error;
+  const bool read = args.count("telemetry") ?
+    ack_6wd_controller::read_joint_state_telemetry(get("telemetry", ""), joint_names, log, error) :
+    ack_6wd_controller::read_joint_state_log(
+      get("bag", ""), get("topic", "/joint_states"), joint_names, log, error);
+  if (!read)
+  {
+    std::cerr << error << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  const double velocity_scale = args.count("velocity-scale") ?
+    std::stod(args["velocity-scale"]) : ack_6wd_controller::RPM_TO_RAD_PER_SEC;
+  const auto samples =
+    ack_6wd_controller::fuse_joint_state_log(log, wheels_per_side, velocity_scale);
+
+  // Apply multipliers the same way the controller does
+  const double wheel_radius = std::stod(get("wheel-radius", "0.0"));
+  const OdometryReplay replay(
+    std::stod(get("wheel-separation-multiplier", "1.0")) *
+      std::stod(get("wheel-separation", "0.0")),
+    std::stod(get("wheel-base-multiplier", "1.0")) * std::stod(get("wheel-base", "0.0")),
+    std::stod(get("left-wheel-radius-multiplier", "1.0")) * wheel_radius,
+    std::stod(get("right-wheel-radius-multiplier", "1.0")) * wheel_radius);
+
+  const size_t thread_count = std::stoul(
+    get("threads", std::to_string(std::max(1u, std::thread::hardware_concurrency()))));
+  const auto trajectory =
+    replay.run(samples, std::stoul(get("segment-size", "20000")), thread_count);
+
+  std::ofstream file;
+  if (!get("output", "").empty())
+  {
+    file.open(get("output", ""));
+    if (!file)
+    {
+      std::cerr << "Unable to open '" << get("output", "") << "' for writing" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  std::ostream & out = file.is_open() ? file : std::cout;
+
+  out << "stamp,x,y,heading\n";
+  char line[128];
+  for (size_t index = 0; index < trajectory.size(); ++index)
+  {
+    std::snprintf(
+      line, sizeof(line), "%.9f,%.6f,%.6f,%.6f\n", samples[index].stamp.seconds(),
+      trajectory[index].x, trajectory[index].y, trajectory[index].heading);
+    out << line;
+  }
+
+  std::cerr << "Replayed " << samples.size() << " of " << log.size() << " joint states"
+            << std::endl;
+  return EXIT_SUCCESS;
+}
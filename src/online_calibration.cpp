@@ -0,0 +1,134 @@
+// Copyright 2021 Faiz Pangestu
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Maintainer : Faiz Pangestu
+ */
+
+#include <cmath>
+
+#include "ack_6wd_controller/online_calibration.hpp"
+
+namespace
+{
+// Samples a gain needs before it is trusted for a suggestion
+constexpr size_t MIN_SAMPLE_COUNT = 200;
+// Gains below this are considered degenerate
+constexpr double MIN_GAIN = 1e-3;
+}  // namespace
+
+namespace ack_6wd_controller
+{
+ScalarRecursiveLeastSquares::ScalarRecursiveLeastSquares(
+  double forgetting_factor, double initial_covariance)
+: forgetting_factor_(forgetting_factor),
+  initial_covariance_(initial_covariance),
+  estimate_(1.0),
+  covariance_(initial_covariance),
+  sample_count_(0)
+{
+}
+
+void ScalarRecursiveLeastSquares::reset(double initial_estimate)
+{
+  estimate_ = initial_estimate;
+  covariance_ = initial_covariance_;
+  sample_count_ = 0;
+}
+
+void ScalarRecursiveLeastSquares::update(double x, double y)
+{
+  const double gain = covariance_ * x / (forgetting_factor_ + x * covariance_ * x);
+  estimate_ += gain * (y - estimate_ * x);
+  covariance_ = (covariance_ - gain * x * covariance_) / forgetting_factor_;
+  ++sample_count_;
+}
+
+OnlineCalibration::OnlineCalibration(
+  double forgetting_factor, double min_linear_velocity, double min_angular_velocity)
+: min_linear_velocity_(min_linear_velocity),
+  min_angular_velocity_(min_angular_velocity),
+  radius_gain_(forgetting_factor),
+  curvature_gain_(forgetting_factor),
+  turn_speed_gain_(forgetting_factor)
+{
+}
+
+void OnlineCalibration::reset()
+{
+  radius_gain_.reset(1.0);
+  curvature_gain_.reset(1.0);
+  turn_speed_gain_.reset(1.0);
+}
+
+void OnlineCalibration::update(
+  double command_linear, double command_angular, double odometry_linear, double odometry_angular,
+  double reference_linear, double reference_angular, bool has_linear)
+{
+  const bool moving = std::abs(command_linear) >= min_linear_velocity_ &&
+                      std::abs(odometry_linear) >= min_linear_velocity_;
+  if (!moving)
+  {
+    return;
+  }
+
+  const bool turning = std::abs(command_angular) >= min_angular_velocity_ &&
+                       std::abs(odometry_angular) >= min_angular_velocity_;
+  if (!turning)
+  {
+    if (has_linear)
+    {
+      radius_gain_.update(odometry_linear, reference_linear);
+    }
+    return;
+  }
+
+  // yaw rate the commanded curvature gives at the speed actually driven
+  const double speed = has_linear ? reference_linear : odometry_linear;
+  curvature_gain_.update(speed * command_angular / command_linear, reference_angular);
+
+  if (has_linear)
+  {
+    // the radius error scales the turning speed as well, keep it out of the compensation
+    turn_speed_gain_.update(command_linear * radius_gain_.getEstimate(), reference_linear);
+  }
+}
+
+OnlineCalibration::Suggestion OnlineCalibration::suggest(
+  double wheel_radius, double steering_angle_correction,
+  double angular_velocity_compensation) const
+{
+  const auto trusted = [](const ScalarRecursiveLeastSquares & fit) {
+    return fit.getSampleCount() >= MIN_SAMPLE_COUNT && std::abs(fit.getEstimate()) > MIN_GAIN;
+  };
+
+  Suggestion suggestion{wheel_radius, steering_angle_correction, angular_velocity_compensation};
+  if (trusted(radius_gain_))
+  {
+    suggestion.wheel_radius = wheel_radius * radius_gain_.getEstimate();
+  }
+  if (trusted(curvature_gain_))
+  {
+    suggestion.steering_angle_correction =
+      steering_angle_correction / curvature_gain_.getEstimate();
+  }
+  if (trusted(turn_speed_gain_))
+  {
+    suggestion.angular_velocity_compensation =
+      angular_velocity_compensation / turn_speed_gain_.getEstimate();
+  }
+  return suggestion;
+}
+
+}  // namespace ack_6wd_controller
@@ -0,0 +1,138 @@
+// Copyright 2021 Faiz Pangestu
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Maintainer : Faiz Pangestu
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "ack_6wd_controller/path_tracker.hpp"
+
+namespace ack_6wd_controller
+{
+bool TrackedPath::assign(const std::vector<PathPoint> & path_points)
+{
+  if (path_points.size() > points.capacity() || path_points.size() > arc_lengths.capacity())
+  {
+    return false;
+  }
+
+  points.assign(path_points.begin(), path_points.end());
+  arc_lengths.resize(points.size());
+  double length = 0.0;
+  for (size_t i = 0; i < points.size(); ++i)
+  {
+    if (i > 0)
+    {
+      length += std::hypot(points[i].x - points[i - 1].x, points[i].y - points[i - 1].y);
+    }
+    arc_lengths[i] = length;
+  }
+  return true;
+}
+
+void PurePursuit::configure(const Params & params)
+{
+  params_ = params;
+  clear();
+}
+
+void PurePursuit::setPath(const TrackedPath & path)
+{
+  path_ = path.points.empty() ? nullptr : &path;
+  progress_ = 0;
+}
+
+void PurePursuit::clear()
+{
+  path_ = nullptr;
+  progress_ = 0;
+}
+
+PurePursuit::Status PurePursuit::compute(
+  double x, double y, double heading, double speed, double & linear, double & angular)
+{
+  linear = 0.0;
+  angular = 0.0;
+  if (path_ == nullptr)
+  {
+    return NO_PATH;
+  }
+
+  const auto & points = path_->points;
+  const auto & arc_lengths = path_->arc_lengths;
+  const size_t last = points.size() - 1;
+  const auto distance = [&points, x, y](size_t i) {
+    return std::hypot(points[i].x - x, points[i].y - y);
+  };
+
+  // nearest point within one maximum lookahead ahead of the progress
+  size_t nearest = progress_;
+  double nearest_distance = distance(progress_);
+  for (size_t i = progress_ + 1;
+       i <= last && arc_lengths[i] - arc_lengths[progress_] <= params_.max_lookahead; ++i)
+  {
+    const double d = distance(i);
+    if (d < nearest_distance)
+    {
+      nearest = i;
+      nearest_distance = d;
+    }
+  }
+  progress_ = nearest;
+
+  // only on the last segment, the start of a closed path is as close to the goal
+  const double remaining = arc_lengths[last] - arc_lengths[progress_] + nearest_distance;
+  if (
+    progress_ + 1 >= last &&
+    (distance(last) < params_.goal_tolerance || remaining < params_.goal_tolerance))
+  {
+    clear();
+    return GOAL_REACHED;
+  }
+
+  // first point at least the lookahead away or along the path, the goal when the path ends
+  // before that
+  const double lookahead = std::min(
+    std::max(params_.lookahead_time * std::fabs(speed), params_.min_lookahead),
+    params_.max_lookahead);
+  size_t target = last;
+  for (size_t i = progress_; i < last; ++i)
+  {
+    if (distance(i) >= lookahead || arc_lengths[i] - arc_lengths[progress_] >= lookahead)
+    {
+      target = i;
+      break;
+    }
+  }
+
+  // curvature of the arc through the target, tangent to the heading
+  const double dx = points[target].x - x;
+  const double dy = points[target].y - y;
+  const double local_y = -std::sin(heading) * dx + std::cos(heading) * dy;
+  const double squared_distance = dx * dx + dy * dy;
+  const double curvature = squared_distance > 1e-9 ? 2.0 * local_y / squared_distance : 0.0;
+
+  linear = params_.speed;
+  if (params_.approach_deceleration > 0.0)
+  {
+    linear = std::min(linear, std::sqrt(2.0 * params_.approach_deceleration * remaining));
+  }
+  angular = linear * curvature;
+  return TRACKING;
+}
+
+}  // namespace ack_6wd_controller
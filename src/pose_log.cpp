@@ -0,0 +1,91 @@
+// Copyright 2021 Faiz Pangestu
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Maintainer : Faiz Pangestu
+ */
+
+
+#include <cmath>
+#include <exception>
+#include <string>
+
+#include "ack_6wd_controller/pose_log.hpp"
+#include "nav_msgs/msg/odometry.hpp"
+#include "rclcpp/serialization.hpp"
+#include "rclcpp/serialized_message.hpp"
+#include "rosbag2_cpp/converter_options.hpp"
+#include "rosbag2_cpp/readers/sequential_reader.hpp"
+#include "rosbag2_storage/storage_options.hpp"
+
+namespace ack_6wd_controller
+{
+bool read_pose_log(
+  const std::string & uri, const std::string & topic, PoseLog & log, std::string & error)
+{
+  log = PoseLog();
+
+  rosbag2_cpp::readers::SequentialReader reader;
+  try
+  {
+    rosbag2_storage::StorageOptions storage_options;
+    storage_options.uri = uri;
+    storage_options.storage_id = "sqlite3";
+
+    rosbag2_cpp::ConverterOptions converter_options;
+    converter_options.input_serialization_format = "cdr";
+    converter_options.output_serialization_format = "cdr";
+
+    reader.open(storage_options, converter_options);
+  }
+  catch (const std::exception & e)
+  {
+    error = "Unable to open bag '" + uri + "': " + e.what();
+    return false;
+  }
+
+  rclcpp::Serialization<nav_msgs::msg::Odometry> serialization;
+  nav_msgs::msg::Odometry msg;
+
+  while (reader.has_next())
+  {
+    const auto bag_message = reader.read_next();
+    if (bag_message->topic_name != topic)
+    {
+      continue;
+    }
+
+    rclcpp::SerializedMessage serialized_msg(*bag_message->serialized_data);
+    serialization.deserialize_message(&serialized_msg, &msg);
+
+    const auto & q = msg.pose.pose.orientation;
+    Pose2D pose;
+    pose.x = msg.pose.pose.position.x;
+    pose.y = msg.pose.pose.position.y;
+    pose.heading = atan2(2.0 * (q.w * q.z + q.x * q.y), 1.0 - 2.0 * (q.y * q.y + q.z * q.z));
+
+    log.stamps.emplace_back(msg.header.stamp);
+    log.poses.push_back(pose);
+  }
+
+  if (log.size() < 2)
+  {
+    error = "Not enough poses on topic '" + topic + "'";
+    return false;
+  }
+
+  return true;
+}
+
+}  // namespace ack_6wd_controller
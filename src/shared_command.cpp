@@ -0,0 +1,143 @@
+// Copyright 2021 Faiz Pangestu
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Maintainer : Faiz Pangestu
+ */
+
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include "ack_6wd_controller/shared_command.hpp"
+
+namespace
+{
+constexpr uint32_t MAGIC = 0x41434b43;  // "ACKC"
+constexpr uint32_t VERSION = 1;
+
+// a read racing a write this many times is left for the next cycle
+constexpr int READ_ATTEMPTS = 4;
+}  // namespace
+
+namespace ack_6wd_controller
+{
+SharedCommandChannel::~SharedCommandChannel()
+{
+  close();
+}
+
+bool SharedCommandChannel::open(const std::string & name, std::string & error)
+{
+  close();
+
+  const int file_descriptor = shm_open(name.c_str(), O_RDWR | O_CREAT, 0660);
+  if (file_descriptor < 0)
+  {
+    error = "Unable to open shared memory '" + name + "': " + strerror(errno);
+    return false;
+  }
+
+  // a new segment is zero filled, i.e. holds no command
+  struct stat status;
+  if (fstat(file_descriptor, &status) != 0 ||
+      (static_cast<size_t>(status.st_size) < sizeof(SharedCommandSegment) &&
+       ftruncate(file_descriptor, sizeof(SharedCommandSegment)) != 0))
+  {
+    error = "Unable to size shared memory '" + name + "': " + strerror(errno);
+    ::close(file_descriptor);
+    return false;
+  }
+
+  void * mapping = mmap(
+    nullptr, sizeof(SharedCommandSegment), PROT_READ | PROT_WRITE, MAP_SHARED, file_descriptor, 0);
+  ::close(file_descriptor);
+  if (mapping == MAP_FAILED)
+  {
+    error = "Unable to map shared memory '" + name + "': " + strerror(errno);
+    return false;
+  }
+
+  segment_ = static_cast<SharedCommandSegment *>(mapping);
+  last_sequence_ = segment_->sequence.load(std::memory_order_acquire);
+  return true;
+}
+
+void SharedCommandChannel::close()
+{
+  if (segment_ != nullptr)
+  {
+    munmap(segment_, sizeof(SharedCommandSegment));
+    segment_ = nullptr;
+  }
+  last_sequence_ = 0;
+}
+
+void SharedCommandChannel::write(const MuxCommand & command)
+{
+  const uint32_t sequence = segment_->sequence.load(std::memory_order_relaxed);
+  segment_->sequence.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  segment_->magic = MAGIC;
+  segment_->version = VERSION;
+  segment_->stamp_ns = command.stamp_ns;
+  segment_->linear = command.linear;
+  segment_->angular = command.angular;
+  std::atomic_thread_fence(std::memory_order_release);
+  segment_->sequence.store(sequence + 2, std::memory_order_relaxed);
+}
+
+bool SharedCommandChannel::read(MuxCommand & command)
+{
+  for (int attempt = 0; attempt < READ_ATTEMPTS; ++attempt)
+  {
+    const uint32_t before = segment_->sequence.load(std::memory_order_acquire);
+    if (before == last_sequence_)
+    {
+      return false;
+    }
+    if ((before & 1u) != 0)
+    {
+      continue;
+    }
+
+    const uint32_t magic = segment_->magic;
+    const uint32_t version = segment_->version;
+    MuxCommand candidate;
+    candidate.stamp_ns = segment_->stamp_ns;
+    candidate.linear = segment_->linear;
+    candidate.angular = segment_->angular;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (segment_->sequence.load(std::memory_order_relaxed) != before)
+    {
+      continue;
+    }
+
+    last_sequence_ = before;
+    if (magic != MAGIC || version != VERSION)
+    {
+      return false;
+    }
+    command = candidate;
+    return true;
+  }
+  return false;
+}
+
+}  // namespace ack_6wd_controller
@@ -0,0 +1,112 @@
+// Copyright 2021 Faiz Pangestu
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Maintainer : Faiz Pangestu
+ */
+
+
+#include <algorithm>
+#include <cmath>
+
+#include "ack_6wd_controller/kinematics.hpp"
+#include "ack_6wd_controller/slip_detector.hpp"
+
+namespace
+{
+// Middle wheels of the controller: middle right then middle left
+constexpr size_t MIDDLE_WHEEL_COUNT = 2;
+}  // namespace
+
+namespace ack_6wd_controller
+{
+void SlipDetector::configure(
+  size_t wheels_per_side, double relative_tolerance, double absolute_tolerance)
+{
+  wheels_per_side_ = wheels_per_side;
+  relative_tolerance_ = relative_tolerance;
+  absolute_tolerance_ = absolute_tolerance;
+
+  const size_t wheel_count = 2 * wheels_per_side + MIDDLE_WHEEL_COUNT;
+  speeds_.assign(wheel_count, 0.0);
+  radii_.assign(wheel_count, 0.0);
+  ratios_.assign(wheel_count, 1.0);
+  implied_.assign(wheel_count, 0.0);
+  valid_.assign(wheel_count, 1.0);
+  scratch_.assign(wheel_count, 0.0);
+  slip_mask_ = 0;
+}
+
+size_t SlipDetector::update(
+  double angle, double wheel_base, double wheel_separation, double left_wheel_radius,
+  double right_wheel_radius, double * left_velocities, double * right_velocities,
+  double * middle_velocities)
+{
+  const size_t n = wheels_per_side_;
+  const size_t wheel_count = speeds_.size();
+
+  double steered_outer = 1.0;
+  double middle_inner = 1.0;
+  double middle_outer = 1.0;
+  wheel_speed_ratios(
+    angle, wheel_base, wheel_separation, steered_outer, middle_inner, middle_outer);
+
+  const bool left_inner = angle >= 0.0;
+  for (size_t i = 0; i < n; ++i)
+  {
+    speeds_[i] = left_velocities[i];
+    speeds_[n + i] = right_velocities[i];
+    radii_[i] = left_wheel_radius;
+    radii_[n + i] = right_wheel_radius;
+    ratios_[i] = left_inner ? 1.0 : steered_outer;
+    ratios_[n + i] = left_inner ? steered_outer : 1.0;
+  }
+  speeds_[2 * n] = middle_velocities[0];
+  speeds_[2 * n + 1] = middle_velocities[1];
+  radii_[2 * n] = right_wheel_radius;
+  radii_[2 * n + 1] = left_wheel_radius;
+  ratios_[2 * n] = left_inner ? middle_outer : middle_inner;
+  ratios_[2 * n + 1] = left_inner ? middle_inner : middle_outer;
+
+  // implied inner wheel speed, branch free so it vectorizes
+  for (size_t i = 0; i < wheel_count; ++i)
+  {
+    implied_[i] = std::abs(speeds_[i]) * radii_[i] / ratios_[i];
+  }
+
+  std::copy(implied_.begin(), implied_.end(), scratch_.begin());
+  std::nth_element(scratch_.begin(), scratch_.begin() + wheel_count / 2, scratch_.end());
+  const double consensus = scratch_[wheel_count / 2];
+  const double tolerance = relative_tolerance_ * consensus + absolute_tolerance_;
+
+  size_t slipping = 0;
+  slip_mask_ = 0;
+  for (size_t i = 0; i < wheel_count; ++i)
+  {
+    valid_[i] = std::abs(implied_[i] - consensus) <= tolerance ? 1.0 : 0.0;
+    const double expected = std::copysign(consensus * ratios_[i] / radii_[i], speeds_[i]);
+    speeds_[i] = valid_[i] * speeds_[i] + (1.0 - valid_[i]) * expected;
+    slipping += valid_[i] == 0.0;
+    slip_mask_ |= static_cast<uint32_t>(valid_[i] == 0.0) << i;
+  }
+
+  std::copy(speeds_.begin(), speeds_.begin() + n, left_velocities);
+  std::copy(speeds_.begin() + n, speeds_.begin() + 2 * n, right_velocities);
+  middle_velocities[0] = speeds_[2 * n];
+  middle_velocities[1] = speeds_[2 * n + 1];
+
+  return slipping;
+}
+
+}  // namespace ack_6wd_controller
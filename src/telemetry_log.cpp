@@ -0,0 +1,465 @@
+// Copyright 2021 Faiz Pangestu
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Maintainer : Faiz Pangestu
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "ack_6wd_controller/telemetry_log.hpp"
+
+namespace
+{
+constexpr char MAGIC[8] = {'A', 'C', 'K', 'T', 'L', 'M', '\0', '\0'};
+constexpr uint32_t VERSION = 1;
+constexpr uint32_t CHUNK_MAGIC = 0x4b4e4843;  // "CHNK"
+
+// quantized value of NaN, never produced by a finite value
+constexpr int64_t QUANTIZED_NAN = std::numeric_limits<int64_t>::min();
+constexpr double QUANTIZED_LIMIT = 9.0e18;
+
+// idle time of the writer thread once the queue is drained
+constexpr auto WRITER_PERIOD = std::chrono::milliseconds(10);
+
+int64_t quantize(double value, double step)
+{
+  if (std::isnan(value))
+  {
+    return QUANTIZED_NAN;
+  }
+  const double scaled = step > 0.0 ? value / step : value;
+  return std::llround(std::max(-QUANTIZED_LIMIT, std::min(QUANTIZED_LIMIT, scaled)));
+}
+
+double dequantize(int64_t value, double step)
+{
+  if (value == QUANTIZED_NAN)
+  {
+    return NAN;
+  }
+  return step > 0.0 ? value * step : static_cast<double>(value);
+}
+
+// differences are taken modulo 2^64 so that any pair of values round trips
+uint64_t zigzag(uint64_t delta)
+{
+  return (delta << 1) ^ (0 - (delta >> 63));
+}
+
+uint64_t unzigzag(uint64_t value)
+{
+  return (value >> 1) ^ (0 - (value & 1));
+}
+
+void put_varint(std::vector<uint8_t> & out, uint64_t value)
+{
+  while (value >= 0x80)
+  {
+    out.push_back(static_cast<uint8_t>(value | 0x80));
+    value >>= 7;
+  }
+  out.push_back(static_cast<uint8_t>(value));
+}
+
+bool get_varint(const uint8_t *& in, const uint8_t * end, uint64_t & value)
+{
+  value = 0;
+  for (int shift = 0; shift < 64 && in < end; shift += 7)
+  {
+    const uint8_t byte = *in++;
+    value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+// order 1 stores deltas, order 2 deltas of deltas
+void encode(const std::vector<int64_t> & values, int order, std::vector<uint8_t> & out)
+{
+  out.clear();
+  uint64_t previous = 0;
+  uint64_t previous_delta = 0;
+  for (const int64_t value : values)
+  {
+    const uint64_t delta = static_cast<uint64_t>(value) - previous;
+    put_varint(out, zigzag(order == 2 ? delta - previous_delta : delta));
+    previous = static_cast<uint64_t>(value);
+    previous_delta = delta;
+  }
+}
+
+bool decode(
+  const std::vector<uint8_t> & in, size_t count, int order, std::vector<int64_t> & values)
+{
+  const uint8_t * data = in.data();
+  const uint8_t * end = data + in.size();
+  uint64_t previous = 0;
+  uint64_t previous_delta = 0;
+  for (size_t row = 0; row < count; ++row)
+  {
+    uint64_t encoded;
+    if (!get_varint(data, end, encoded))
+    {
+      return false;
+    }
+    const uint64_t delta = order == 2 ? unzigzag(encoded) + previous_delta : unzigzag(encoded);
+    previous += delta;
+    previous_delta = delta;
+    values.push_back(static_cast<int64_t>(previous));
+  }
+  return true;
+}
+
+template <typename T>
+void put(std::ofstream & file, T value)
+{
+  uint8_t bytes[sizeof(T)];
+  uint64_t bits = 0;
+  std::memcpy(&bits, &value, sizeof(T));
+  for (size_t i = 0; i < sizeof(T); ++i)
+  {
+    bytes[i] = static_cast<uint8_t>(bits >> (8 * i));
+  }
+  file.write(reinterpret_cast<const char *>(bytes), sizeof(T));
+}
+
+template <typename T>
+bool get(std::ifstream & file, T & value)
+{
+  uint8_t bytes[sizeof(T)];
+  if (!file.read(reinterpret_cast<char *>(bytes), sizeof(T)))
+  {
+    return false;
+  }
+  uint64_t bits = 0;
+  for (size_t i = 0; i < sizeof(T); ++i)
+  {
+    bits |= static_cast<uint64_t>(bytes[i]) << (8 * i);
+  }
+  std::memcpy(&value, &bits, sizeof(T));
+  return true;
+}
+}  // namespace
+
+namespace ack_6wd_controller
+{
+TelemetryWriter::~TelemetryWriter()
+{
+  close();
+}
+
+bool TelemetryWriter::open(
+  const std::string & path, const std::vector<TelemetryColumn> & columns, size_t chunk_rows,
+  size_t queue_size, std::string & error)
+{
+  close();
+
+  if (columns.size() > TELEMETRY_MAX_COLUMNS)
+  {
+    error = "Telemetry supports up to " + std::to_string(TELEMETRY_MAX_COLUMNS) +
+            " columns, got " + std::to_string(columns.size());
+    return false;
+  }
+  if (chunk_rows == 0 || queue_size == 0)
+  {
+    error = "Telemetry chunk and queue sizes must be > 0";
+    return false;
+  }
+
+  file_.open(path, std::ios::binary | std::ios::trunc);
+  if (!file_)
+  {
+    error = "Unable to open '" + path + "' for writing";
+    return false;
+  }
+
+  file_.write(MAGIC, sizeof(MAGIC));
+  put<uint32_t>(file_, VERSION);
+  put<uint32_t>(file_, static_cast<uint32_t>(columns.size()));
+  for (const auto & column : columns)
+  {
+    put<uint32_t>(file_, static_cast<uint32_t>(column.name.size()));
+    file_.write(column.name.data(), static_cast<std::streamsize>(column.name.size()));
+    put<double>(file_, column.step);
+  }
+
+  columns_ = columns;
+  chunk_rows_ = chunk_rows;
+  stamps_.clear();
+  stamps_.reserve(chunk_rows_);
+  quantized_.assign(columns_.size(), std::vector<int64_t>());
+  for (auto & column : quantized_)
+  {
+    column.reserve(chunk_rows_);
+  }
+  encoded_.assign(columns_.size() + 1, std::vector<uint8_t>());
+
+  queue_.reset(new SpscQueue<TelemetrySample>(queue_size));
+  dropped_ = 0;
+  running_ = true;
+  thread_ = std::thread(&TelemetryWriter::run, this);
+  return true;
+}
+
+void TelemetryWriter::close()
+{
+  if (!thread_.joinable())
+  {
+    return;
+  }
+  running_ = false;
+  thread_.join();
+  flush();
+  file_.close();
+  queue_.reset();
+}
+
+bool TelemetryWriter::push(const TelemetrySample & sample)
+{
+  if (!queue_ || !queue_->push(sample))
+  {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  return true;
+}
+
+void TelemetryWriter::run()
+{
+  TelemetrySample sample;
+  while (true)
+  {
+    // read the flag first, samples pushed before close() are then still drained
+    const bool running = running_.load();
+    bool received = false;
+    while (queue_->pop(sample))
+    {
+      received = true;
+      stamps_.push_back(sample.stamp_ns);
+      for (size_t column = 0; column < columns_.size(); ++column)
+      {
+        quantized_[column].push_back(quantize(sample.values[column], columns_[column].step));
+      }
+      if (stamps_.size() >= chunk_rows_)
+      {
+        flush();
+      }
+    }
+
+    if (!running)
+    {
+      return;
+    }
+    if (!received)
+    {
+      std::this_thread::sleep_for(WRITER_PERIOD);
+    }
+  }
+}
+
+void TelemetryWriter::flush()
+{
+  if (stamps_.empty())
+  {
+    return;
+  }
+
+  encode(stamps_, 2, encoded_[0]);
+  for (size_t column = 0; column < columns_.size(); ++column)
+  {
+    encode(quantized_[column], 1, encoded_[column + 1]);
+  }
+
+  put<uint32_t>(file_, CHUNK_MAGIC);
+  put<uint32_t>(file_, static_cast<uint32_t>(stamps_.size()));
+  put<uint32_t>(file_, static_cast<uint32_t>(encoded_.size()));
+  for (const auto & slot : encoded_)
+  {
+    put<uint64_t>(file_, slot.size());
+  }
+  for (const auto & slot : encoded_)
+  {
+    file_.write(
+      reinterpret_cast<const char *>(slot.data()), static_cast<std::streamsize>(slot.size()));
+  }
+  file_.flush();
+
+  stamps_.clear();
+  for (auto & column : quantized_)
+  {
+    column.clear();
+  }
+}
+
+bool TelemetryReader::open(const std::string & path, std::string & error)
+{
+  path_ = path;
+  columns_.clear();
+  file_.close();
+  file_.clear();
+  file_.open(path, std::ios::binary);
+  if (!file_)
+  {
+    error = "Unable to open '" + path + "'";
+    return false;
+  }
+
+  char magic[sizeof(MAGIC)];
+  uint32_t version = 0;
+  uint32_t column_count = 0;
+  if (!file_.read(magic, sizeof(magic)) || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0)
+  {
+    error = "'" + path + "' is not a telemetry log";
+    return false;
+  }
+  if (!get(file_, version) || version != VERSION || !get(file_, column_count))
+  {
+    error = "'" + path + "' was written by an incompatible version";
+    return false;
+  }
+
+  for (uint32_t index = 0; index < column_count; ++index)
+  {
+    uint32_t length = 0;
+    TelemetryColumn column;
+    if (!get(file_, length))
+    {
+      error = "'" + path + "' has a truncated header";
+      return false;
+    }
+    column.name.resize(length);
+    if (!file_.read(&column.name[0], length) || !get(file_, column.step))
+    {
+      error = "'" + path + "' has a truncated header";
+      return false;
+    }
+    columns_.push_back(column);
+  }
+
+  data_offset_ = file_.tellg();
+  file_.seekg(0, std::ios::end);
+  file_size_ = file_.tellg();
+  return true;
+}
+
+size_t TelemetryReader::find(const std::string & name) const
+{
+  for (size_t index = 0; index < columns_.size(); ++index)
+  {
+    if (columns_[index].name == name)
+    {
+      return index;
+    }
+  }
+  return columns_.size();
+}
+
+bool TelemetryReader::read_stamps(std::vector<int64_t> & stamps, std::string & error)
+{
+  stamps.clear();
+  return read_slot(0, stamps, error);
+}
+
+bool TelemetryReader::read_column(
+  size_t column, std::vector<double> & values, std::string & error)
+{
+  values.clear();
+  if (column >= columns_.size())
+  {
+    error = "'" + path_ + "' has no column " + std::to_string(column);
+    return false;
+  }
+
+  std::vector<int64_t> quantized;
+  if (!read_slot(column + 1, quantized, error))
+  {
+    return false;
+  }
+  values.reserve(quantized.size());
+  for (const int64_t value : quantized)
+  {
+    values.push_back(dequantize(value, columns_[column].step));
+  }
+  return true;
+}
+
+bool TelemetryReader::read_slot(size_t slot, std::vector<int64_t> & values, std::string & error)
+{
+  file_.clear();
+  file_.seekg(data_offset_);
+
+  std::vector<uint64_t> sizes;
+  std::vector<uint8_t> encoded;
+  uint32_t magic = 0;
+  // a chunk cut short by a crash ends the log
+  while (get(file_, magic))
+  {
+    uint32_t row_count = 0;
+    uint32_t slot_count = 0;
+    if (magic != CHUNK_MAGIC || !get(file_, row_count) || !get(file_, slot_count) ||
+        slot_count != columns_.size() + 1)
+    {
+      error = "'" + path_ + "' has a corrupted chunk";
+      return false;
+    }
+
+    sizes.resize(slot_count);
+    for (auto & size : sizes)
+    {
+      if (!get(file_, size))
+      {
+        return true;
+      }
+    }
+
+    uint64_t offset = 0;
+    uint64_t chunk_size = 0;
+    for (size_t index = 0; index < slot_count; ++index)
+    {
+      offset += index < slot ? sizes[index] : 0;
+      chunk_size += sizes[index];
+    }
+
+    // every column then has the same rows, whichever is read
+    const std::streamoff chunk_start = file_.tellg();
+    if (chunk_start + static_cast<std::streamoff>(chunk_size) > file_size_)
+    {
+      return true;
+    }
+
+    file_.seekg(chunk_start + static_cast<std::streamoff>(offset));
+    encoded.resize(sizes[slot]);
+    file_.read(
+      reinterpret_cast<char *>(encoded.data()), static_cast<std::streamsize>(encoded.size()));
+    if (!file_ || !decode(encoded, row_count, slot == 0 ? 2 : 1, values))
+    {
+      error = "'" + path_ + "' has a corrupted column";
+      return false;
+    }
+    file_.seekg(chunk_start + static_cast<std::streamoff>(chunk_size));
+  }
+  return true;
+}
+
+}  // namespace ack_6wd_controller
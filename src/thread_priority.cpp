@@ -0,0 +1,157 @@
+// Copyright 2021 Faiz Pangestu
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Maintainer : Faiz Pangestu
+ */
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ack_6wd_controller/thread_priority.hpp"
+
+namespace ack_6wd_controller
+{
+bool parse_thread_schedule(
+  const std::string & policy, int64_t priority, const std::vector<int64_t> & cpu_affinity,
+  ThreadSchedule & schedule, std::string & error)
+{
+  schedule = ThreadSchedule();
+  schedule.cpu_affinity.assign(cpu_affinity.begin(), cpu_affinity.end());
+
+  if (policy.empty())
+  {
+    return true;
+  }
+
+  const std::pair<const char *, int> policies[] = {
+    {"fifo", SCHED_FIFO}, {"rr", SCHED_RR}, {"other", SCHED_OTHER},
+    {"batch", SCHED_BATCH}, {"idle", SCHED_IDLE},
+  };
+  for (const auto & known : policies)
+  {
+    if (policy == known.first)
+    {
+      schedule.policy = known.second;
+    }
+  }
+  if (schedule.policy == THREAD_POLICY_KEEP)
+  {
+    error = "Unknown scheduling policy '" + policy + "'";
+    return false;
+  }
+
+  const int min_priority = sched_get_priority_min(schedule.policy);
+  const int max_priority = sched_get_priority_max(schedule.policy);
+  if (priority < min_priority || priority > max_priority)
+  {
+    error = "Priority " + std::to_string(priority) + " of policy '" + policy + "' is not in [" +
+            std::to_string(min_priority) + ", " + std::to_string(max_priority) + "]";
+    return false;
+  }
+  schedule.priority = static_cast<int>(priority);
+  return true;
+}
+
+bool apply_thread_schedule(const ThreadSchedule & schedule, std::string & error)
+{
+  if (!schedule.cpu_affinity.empty())
+  {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    for (const int cpu : schedule.cpu_affinity)
+    {
+      if (cpu < 0 || cpu >= CPU_SETSIZE)
+      {
+        error = "Invalid CPU " + std::to_string(cpu);
+        return false;
+      }
+      CPU_SET(cpu, &cpus);
+    }
+
+    const int result = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    if (result != 0)
+    {
+      error = std::string("Unable to set the CPU affinity: ") + strerror(result);
+      return false;
+    }
+  }
+
+  if (schedule.policy != THREAD_POLICY_KEEP)
+  {
+    sched_param param;
+    std::memset(&param, 0, sizeof(param));
+    param.sched_priority = schedule.priority;
+
+    const int result = pthread_setschedparam(pthread_self(), schedule.policy, &param);
+    if (result != 0)
+    {
+      error = "Unable to set policy " + std::to_string(schedule.policy) + " with priority " +
+              std::to_string(schedule.priority) + ": " + strerror(result);
+      return false;
+    }
+  }
+  return true;
+}
+
+ScopedThreadSchedule::ScopedThreadSchedule(const ThreadSchedule & schedule)
+{
+  std::memset(&previous_param_, 0, sizeof(previous_param_));
+  CPU_ZERO(&previous_cpus_);
+
+  if (
+    pthread_getschedparam(pthread_self(), &previous_policy_, &previous_param_) != 0 ||
+    pthread_getaffinity_np(pthread_self(), sizeof(previous_cpus_), &previous_cpus_) != 0)
+  {
+    error_ = "Unable to read the scheduling of the calling thread";
+    return;
+  }
+
+  active_ = true;
+  if (!apply_thread_schedule(schedule, error_))
+  {
+    // a partially applied schedule is undone as well
+    restore();
+  }
+}
+
+ScopedThreadSchedule::~ScopedThreadSchedule()
+{
+  restore();
+}
+
+bool ScopedThreadSchedule::restore()
+{
+  if (!active_)
+  {
+    return true;
+  }
+  active_ = false;
+
+  const bool restored =
+    pthread_setaffinity_np(pthread_self(), sizeof(previous_cpus_), &previous_cpus_) == 0 &&
+    pthread_setschedparam(pthread_self(), previous_policy_, &previous_param_) == 0;
+  if (!restored && error_.empty())
+  {
+    error_ = "Unable to restore the scheduling of the calling thread";
+  }
+  return restored;
+}
+
+}  // namespace ack_6wd_controller
@@ -0,0 +1,94 @@
+// Copyright 2021 Faiz Pangestu
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Maintainer : Faiz Pangestu
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "ack_6wd_controller/tracking_monitor.hpp"
+
+namespace ack_6wd_controller
+{
+void TrackingMonitor::configure(size_t joint_count, size_t max_lag, double smoothing)
+{
+  joint_count_ = joint_count;
+  history_size_ = max_lag + 1;
+  smoothing_ = smoothing;
+
+  history_.assign(joint_count_ * history_size_, 0.0);
+  mean_squares_.assign(joint_count_ * history_size_, 0.0);
+  lags_.assign(joint_count_, 0);
+  reset();
+}
+
+void TrackingMonitor::reset()
+{
+  std::fill(history_.begin(), history_.end(), 0.0);
+  std::fill(mean_squares_.begin(), mean_squares_.end(), 0.0);
+  std::fill(lags_.begin(), lags_.end(), 0);
+  head_ = 0;
+  filled_ = 0;
+  sample_count_ = 0;
+  period_ = 0.0;
+}
+
+void TrackingMonitor::update(const double * commands, const double * states, double period)
+{
+  head_ = (head_ + 1) % history_size_;
+  if (filled_ < history_size_)
+  {
+    ++filled_;
+  }
+  ++sample_count_;
+
+  // average from the first sample on instead of from zero
+  const double weight = std::max(smoothing_, 1.0 / sample_count_);
+  period_ += weight * (period - period_);
+
+  for (size_t joint = 0; joint < joint_count_; ++joint)
+  {
+    double * history = &history_[joint * history_size_];
+    double * mean_squares = &mean_squares_[joint * history_size_];
+    history[head_] = commands[joint];
+
+    size_t best_lag = 0;
+    for (size_t lag = 0; lag < filled_; ++lag)
+    {
+      const double error = states[joint] - history[(head_ + history_size_ - lag) % history_size_];
+      // delays reach the full history one cycle apart, keep their averages comparable
+      const double lag_weight = std::max(smoothing_, 1.0 / (sample_count_ - lag));
+      mean_squares[lag] += lag_weight * (error * error - mean_squares[lag]);
+      if (mean_squares[lag] < mean_squares[best_lag])
+      {
+        best_lag = lag;
+      }
+    }
+    lags_[joint] = best_lag;
+  }
+}
+
+double TrackingMonitor::getRmsError(size_t joint) const
+{
+  return std::sqrt(mean_squares_[joint * history_size_]);
+}
+
+double TrackingMonitor::getLaggedRmsError(size_t joint) const
+{
+  return std::sqrt(mean_squares_[joint * history_size_ + lags_[joint]]);
+}
+
+}  // namespace ack_6wd_controller
@@ -0,0 +1,219 @@
+// Copyright 2021 Faiz Pangestu
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Maintainer : Faiz Pangestu
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+#include "ack_6wd_controller/zone_map.hpp"
+
+namespace
+{
+// about 40 MB of cells
+constexpr size_t MAX_CELLS = 10000000;
+
+struct Zone
+{
+  double max_speed;
+  std::vector<double> x;
+  std::vector<double> y;
+  double min_x, min_y, max_x, max_y;  // bounding box
+};
+
+bool contains(const Zone & zone, double x, double y)
+{
+  bool inside = false;
+  const size_t count = zone.x.size();
+  for (size_t i = 0, j = count - 1; i < count; j = i++)
+  {
+    if (
+      (zone.y[i] > y) != (zone.y[j] > y) &&
+      x < (zone.x[j] - zone.x[i]) * (y - zone.y[i]) / (zone.y[j] - zone.y[i]) + zone.x[i])
+    {
+      inside = !inside;
+    }
+  }
+  return inside;
+}
+
+double edge_distance(const Zone & zone, double x, double y)
+{
+  double distance = std::numeric_limits<double>::infinity();
+  const size_t count = zone.x.size();
+  for (size_t i = 0, j = count - 1; i < count; j = i++)
+  {
+    const double dx = zone.x[i] - zone.x[j];
+    const double dy = zone.y[i] - zone.y[j];
+    const double squared_length = dx * dx + dy * dy;
+    double t = 0.0;
+    if (squared_length > 0.0)
+    {
+      t = ((x - zone.x[j]) * dx + (y - zone.y[j]) * dy) / squared_length;
+      t = std::min(std::max(t, 0.0), 1.0);
+    }
+    distance =
+      std::min(distance, std::hypot(zone.x[j] + t * dx - x, zone.y[j] + t * dy - y));
+  }
+  return distance;
+}
+}  // namespace
+
+namespace ack_6wd_controller
+{
+bool ZoneMap::load(
+  const std::string & path, double resolution, double margin, std::string & error)
+{
+  clear();
+  if (!(resolution > 0.0) || !(margin >= 0.0))
+  {
+    error = "Zone map needs a resolution > 0 and a margin >= 0";
+    return false;
+  }
+
+  std::ifstream file(path);
+  if (!file)
+  {
+    error = "Unable to open '" + path + "'";
+    return false;
+  }
+
+  std::vector<Zone> zones;
+  double min_x = std::numeric_limits<double>::infinity();
+  double min_y = min_x;
+  double max_x = -min_x;
+  double max_y = -min_x;
+  std::string line;
+  for (size_t line_number = 1; std::getline(file, line); ++line_number)
+  {
+    const auto comment = line.find('#');
+    if (comment != std::string::npos)
+    {
+      line.erase(comment);
+    }
+    std::istringstream stream(line);
+    Zone zone;
+    if (!(stream >> zone.max_speed))
+    {
+      // blank line
+      continue;
+    }
+    double x, y;
+    bool dangling = false;
+    while (stream >> x)
+    {
+      if (!(stream >> y))
+      {
+        // an x without its y
+        dangling = true;
+        break;
+      }
+      zone.x.push_back(x);
+      zone.y.push_back(y);
+      min_x = std::min(min_x, x);
+      min_y = std::min(min_y, y);
+      max_x = std::max(max_x, x);
+      max_y = std::max(max_y, y);
+    }
+    if (dangling || !stream.eof() || zone.x.size() < 3 || !(zone.max_speed >= 0.0))
+    {
+      error = "'" + path + "' line " + std::to_string(line_number) +
+              ": expected a max speed >= 0 and at least three x y vertices";
+      return false;
+    }
+    zone.min_x = *std::min_element(zone.x.begin(), zone.x.end());
+    zone.max_x = *std::max_element(zone.x.begin(), zone.x.end());
+    zone.min_y = *std::min_element(zone.y.begin(), zone.y.end());
+    zone.max_y = *std::max_element(zone.y.begin(), zone.y.end());
+    zones.push_back(zone);
+  }
+  if (zones.empty())
+  {
+    return true;
+  }
+
+  // a cell overlaps a zone when its center is inside or at most half a diagonal from an edge,
+  // slightly more than the exact overlap, on the safe side for a speed limit
+  const double reach = margin + resolution * std::sqrt(0.5);
+  resolution_ = resolution;
+  origin_x_ = min_x - reach;
+  origin_y_ = min_y - reach;
+  const double width = std::ceil((max_x + reach - origin_x_) / resolution) + 1.0;
+  const double height = std::ceil((max_y + reach - origin_y_) / resolution) + 1.0;
+  if (width * height > static_cast<double>(MAX_CELLS))
+  {
+    error = "The zones of '" + path + "' span too many cells, increase the resolution";
+    return false;
+  }
+  width_ = static_cast<size_t>(width);
+  height_ = static_cast<size_t>(height);
+  cells_.assign(width_ * height_, std::numeric_limits<float>::infinity());
+
+  // each zone only over its own bounding box, grown by the reach
+  const auto cell_index = [this](double coordinate, double origin, size_t size) {
+    const double index = std::floor((coordinate - origin) / resolution_);
+    return static_cast<size_t>(std::min(std::max(index, 0.0), static_cast<double>(size - 1)));
+  };
+  for (const auto & zone : zones)
+  {
+    const size_t first_column = cell_index(zone.min_x - reach, origin_x_, width_);
+    const size_t last_column = cell_index(zone.max_x + reach, origin_x_, width_);
+    const size_t first_row = cell_index(zone.min_y - reach, origin_y_, height_);
+    const size_t last_row = cell_index(zone.max_y + reach, origin_y_, height_);
+    for (size_t row = first_row; row <= last_row; ++row)
+    {
+      const double y = origin_y_ + (row + 0.5) * resolution_;
+      for (size_t column = first_column; column <= last_column; ++column)
+      {
+        const double x = origin_x_ + (column + 0.5) * resolution_;
+        auto & cell = cells_[row * width_ + column];
+        if (
+          zone.max_speed < cell &&
+          (contains(zone, x, y) || edge_distance(zone, x, y) <= reach))
+        {
+          cell = static_cast<float>(zone.max_speed);
+        }
+      }
+    }
+  }
+  zone_count_ = zones.size();
+  return true;
+}
+
+void ZoneMap::clear()
+{
+  width_ = 0;
+  height_ = 0;
+  cells_.clear();
+  zone_count_ = 0;
+}
+
+double ZoneMap::getSpeedLimit(double x, double y) const
+{
+  const double column = std::floor((x - origin_x_) / resolution_);
+  const double row = std::floor((y - origin_y_) / resolution_);
+  // also false for NaN
+  if (!(column >= 0.0 && row >= 0.0 && column < width_ && row < height_))
+  {
+    return std::numeric_limits<double>::infinity();
+  }
+  return cells_[static_cast<size_t>(row) * width_ + static_cast<size_t>(column)];
+}
+
+}  // namespace ack_6wd_controller
@@ -0,0 +1,118 @@
+// Copyright 2021 Faiz Pangestu
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Maintainer : Faiz Pangestu
+ */
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "ack_6wd_controller/change_filter.hpp"
+
+using ack_6wd_controller::CommandChangeFilter;
+
+TEST(CommandChangeFilter, SendsEveryJointFirst)
+{
+  CommandChangeFilter filter;
+  std::string error;
+  ASSERT_TRUE(filter.configure({0.1, 0.1, 0.1}, 0, error));
+
+  double values[] = {0.0, 1.0, -1.0};
+  EXPECT_EQ(filter.update(values), 0x7u);
+  EXPECT_EQ(filter.getMask(), 0x7u);
+}
+
+TEST(CommandChangeFilter, HoldsChangesWithinTheDeadband)
+{
+  CommandChangeFilter filter;
+  std::string error;
+  ASSERT_TRUE(filter.configure({0.1, 0.1}, 0, error));
+
+  double values[] = {1.0, 2.0};
+  filter.update(values);
+
+  values[0] = 1.05;
+  values[1] = 2.5;
+  EXPECT_EQ(filter.update(values), 0x2u);
+  // the clean joint keeps what was sent
+  EXPECT_DOUBLE_EQ(values[0], 1.0);
+  EXPECT_DOUBLE_EQ(values[1], 2.5);
+
+  // drifting in small steps is measured against the value sent, not the last one seen
+  values[0] = 1.08;
+  EXPECT_EQ(filter.update(values), 0x0u);
+  values[0] = 1.15;
+  EXPECT_EQ(filter.update(values), 0x1u);
+  EXPECT_DOUBLE_EQ(values[0], 1.15);
+}
+
+TEST(CommandChangeFilter, AlwaysSendsAStop)
+{
+  CommandChangeFilter filter;
+  std::string error;
+  ASSERT_TRUE(filter.configure({0.1}, 0, error));
+
+  double value = 0.05;
+  filter.update(&value);
+
+  value = 0.0;
+  EXPECT_EQ(filter.update(&value), 0x1u);
+  EXPECT_DOUBLE_EQ(value, 0.0);
+
+  // once the stop was sent, it is clean
+  EXPECT_EQ(filter.update(&value), 0x0u);
+}
+
+TEST(CommandChangeFilter, RefreshesCleanJoints)
+{
+  CommandChangeFilter filter;
+  std::string error;
+  ASSERT_TRUE(filter.configure({0.1}, 3, error));
+
+  double value = 1.0;
+  EXPECT_EQ(filter.update(&value), 0x1u);
+  EXPECT_EQ(filter.update(&value), 0x0u);
+  EXPECT_EQ(filter.update(&value), 0x0u);
+  EXPECT_EQ(filter.update(&value), 0x1u);
+  EXPECT_EQ(filter.update(&value), 0x0u);
+}
+
+TEST(CommandChangeFilter, ResetSendsEveryJoint)
+{
+  CommandChangeFilter filter;
+  std::string error;
+  ASSERT_TRUE(filter.configure({0.1, 0.1}, 0, error));
+
+  double values[] = {1.0, 2.0};
+  filter.update(values);
+  EXPECT_EQ(filter.update(values), 0x0u);
+
+  filter.reset();
+  EXPECT_EQ(filter.update(values), 0x3u);
+}
+
+TEST(CommandChangeFilter, RejectsInvalidConfigurations)
+{
+  CommandChangeFilter filter;
+  std::string error;
+  EXPECT_FALSE(filter.configure({0.1, -0.1}, 0, error));
+  EXPECT_FALSE(error.empty());
+  EXPECT_FALSE(filter.configure(
+    std::vector<double>(CommandChangeFilter::MAX_JOINTS + 1, 0.0), 0, error));
+  EXPECT_TRUE(
+    filter.configure(std::vector<double>(CommandChangeFilter::MAX_JOINTS, 0.0), 0, error));
+}
@@ -0,0 +1,141 @@
+// Copyright 2021 Faiz Pangestu
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Maintainer : Faiz Pangestu
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ack_6wd_controller/command_mux.hpp"
+
+using ack_6wd_controller::CommandMux;
+using ack_6wd_controller::MuxCommand;
+
+namespace
+{
+constexpr int64_t MS = 1000000;
+constexpr CommandMux::OfferResult ACCEPTED = CommandMux::OFFER_ACCEPTED;
+constexpr CommandMux::OfferResult DUPLICATE = CommandMux::OFFER_DUPLICATE;
+constexpr CommandMux::OfferResult REORDERED = CommandMux::OFFER_REORDERED;
+
+MuxCommand make_command(int64_t stamp_ns, double linear, double angular = 0.0)
+{
+  MuxCommand command;
+  command.stamp_ns = stamp_ns;
+  command.linear = linear;
+  command.angular = angular;
+  return command;
+}
+
+class CommandMuxTest : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    std::string error;
+    // listed in another order than their priorities
+    ASSERT_TRUE(mux_.configure(
+      {{"navigation", 10, 500 * MS}, {"teleop", 100, 200 * MS}, {"fallback", 0, 1000 * MS}},
+      error))
+      << error;
+    navigation_ = mux_.find("navigation");
+    teleop_ = mux_.find("teleop");
+  }
+
+  CommandMux mux_;
+  size_t navigation_ = 0;
+  size_t teleop_ = 0;
+};
+}  // namespace
+
+TEST_F(CommandMuxTest, FindsInputsByName)
+{
+  EXPECT_EQ(navigation_, 0u);
+  EXPECT_EQ(teleop_, 1u);
+  EXPECT_EQ(mux_.find("missing"), mux_.size());
+}
+
+TEST_F(CommandMuxTest, SelectsTheFreshInputWithTheHighestPriority)
+{
+  MuxCommand command;
+  EXPECT_EQ(mux_.select(1000 * MS, command), mux_.size());
+  EXPECT_EQ(command.stamp_ns, 1000 * MS);
+  EXPECT_DOUBLE_EQ(command.linear, 0.0);
+
+  mux_.offer(navigation_, make_command(1000 * MS, 0.5), 1000 * MS);
+  mux_.offer(teleop_, make_command(1000 * MS, 1.0, 0.2), 1000 * MS);
+  EXPECT_EQ(mux_.select(1100 * MS, command), teleop_);
+  EXPECT_DOUBLE_EQ(command.linear, 1.0);
+  EXPECT_DOUBLE_EQ(command.angular, 0.2);
+
+  // teleop timed out, navigation takes over until it times out as well
+  EXPECT_EQ(mux_.select(1300 * MS, command), navigation_);
+  EXPECT_DOUBLE_EQ(command.linear, 0.5);
+  EXPECT_EQ(mux_.select(1600 * MS, command), mux_.size());
+  EXPECT_DOUBLE_EQ(command.linear, 0.0);
+}
+
+TEST_F(CommandMuxTest, ClearForgetsAllCommands)
+{
+  mux_.offer(teleop_, make_command(1000 * MS, 1.0), 1000 * MS);
+  mux_.clear();
+  MuxCommand command;
+  EXPECT_EQ(mux_.select(1000 * MS, command), mux_.size());
+}
+
+TEST_F(CommandMuxTest, RejectsDuplicateAndReorderedStamps)
+{
+  mux_.setStampCheck(true, 20 * MS);
+  EXPECT_EQ(mux_.offer(teleop_, make_command(1000 * MS, 1.0), 1000 * MS), ACCEPTED);
+  EXPECT_EQ(mux_.offer(teleop_, make_command(1000 * MS, 2.0), 1010 * MS), DUPLICATE);
+  EXPECT_EQ(mux_.offer(teleop_, make_command(950 * MS, 3.0), 1010 * MS), REORDERED);
+  // within the tolerance
+  EXPECT_EQ(mux_.offer(teleop_, make_command(990 * MS, 4.0), 1010 * MS), ACCEPTED);
+  EXPECT_EQ(mux_.getDuplicateCount(teleop_), 1u);
+  EXPECT_EQ(mux_.getReorderedCount(teleop_), 1u);
+
+  MuxCommand command;
+  EXPECT_EQ(mux_.select(1010 * MS, command), teleop_);
+  EXPECT_DOUBLE_EQ(command.linear, 4.0);
+}
+
+TEST_F(CommandMuxTest, AcceptsAnyStampOnceTheHeldCommandTimedOut)
+{
+  mux_.setStampCheck(true, 0);
+  mux_.offer(teleop_, make_command(5000 * MS, 1.0), 5000 * MS);
+  EXPECT_EQ(mux_.offer(teleop_, make_command(4900 * MS, 2.0), 5100 * MS), REORDERED);
+  // e.g. a restarted publisher with a clock slightly behind the old one
+  EXPECT_EQ(mux_.offer(teleop_, make_command(4900 * MS, 2.0), 5300 * MS), ACCEPTED);
+}
+
+TEST_F(CommandMuxTest, AcceptsEverythingWithoutTheStampCheck)
+{
+  mux_.offer(teleop_, make_command(1000 * MS, 1.0), 1000 * MS);
+  EXPECT_EQ(mux_.offer(teleop_, make_command(1000 * MS, 2.0), 1000 * MS), ACCEPTED);
+  EXPECT_EQ(mux_.offer(teleop_, make_command(500 * MS, 3.0), 1000 * MS), ACCEPTED);
+}
+
+TEST(CommandMux, RejectsInvalidInputs)
+{
+  CommandMux mux;
+  std::string error;
+  EXPECT_FALSE(mux.configure({{"teleop", 1, 0}}, error));
+  EXPECT_FALSE(error.empty());
+  EXPECT_FALSE(mux.configure({{"teleop", 1, MS}, {"teleop", 2, MS}}, error));
+}
@@ -0,0 +1,137 @@
+// Copyright 2021 Faiz Pangestu
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Maintainer : Faiz Pangestu
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+#include "ack_6wd_controller/command_predictor.hpp"
+
+using ack_6wd_controller::CommandPredictor;
+
+namespace
+{
+constexpr int64_t MS = 1000000;
+}  // namespace
+
+TEST(CommandPredictor, CommandsZeroWithoutCommands)
+{
+  CommandPredictor predictor;
+  predictor.configure(1, 0.25, 0.5);
+  double linear = 1.0;
+  double angular = 1.0;
+  predictor.predict(1000 * MS, linear, angular);
+  EXPECT_DOUBLE_EQ(linear, 0.0);
+  EXPECT_DOUBLE_EQ(angular, 0.0);
+}
+
+TEST(CommandPredictor, OrderZeroHoldsTheLastCommand)
+{
+  CommandPredictor predictor;
+  predictor.configure(0, 0.25, 0.5);
+  predictor.add(1000 * MS, 1.0, 0.1);
+  predictor.add(1100 * MS, 1.2, 0.2);
+  double linear, angular;
+  predictor.predict(1150 * MS, linear, angular);
+  EXPECT_DOUBLE_EQ(linear, 1.2);
+  EXPECT_DOUBLE_EQ(angular, 0.2);
+}
+
+TEST(CommandPredictor, ExtrapolatesLinearly)
+{
+  CommandPredictor predictor;
+  predictor.configure(1, 0.25, 0.5);
+  predictor.add(1000 * MS, 1.0, 0.1);
+
+  // one command does not tell a trend
+  double linear, angular;
+  predictor.predict(1050 * MS, linear, angular);
+  EXPECT_DOUBLE_EQ(linear, 1.0);
+
+  predictor.add(1100 * MS, 1.2, 0.2);
+  predictor.predict(1150 * MS, linear, angular);
+  EXPECT_NEAR(linear, 1.3, 1e-9);
+  EXPECT_NEAR(angular, 0.25, 1e-9);
+}
+
+TEST(CommandPredictor, ExtrapolatesQuadratically)
+{
+  CommandPredictor predictor;
+  predictor.configure(2, 0.25, 0.5);
+  // v = 1 + t^2, t in units of 100 ms
+  predictor.add(1000 * MS, 1.0, 0.0);
+  predictor.add(1100 * MS, 2.0, 0.0);
+  predictor.add(1200 * MS, 5.0, 0.0);
+  double linear, angular;
+  predictor.predict(1300 * MS, linear, angular);
+  EXPECT_NEAR(linear, 10.0, 1e-9);
+}
+
+TEST(CommandPredictor, HoldsSparseCommands)
+{
+  CommandPredictor predictor;
+  predictor.configure(1, 0.25, 0.5);
+  predictor.add(1000 * MS, 1.0, 0.0);
+  predictor.add(1300 * MS, 1.2, 0.0);
+  double linear, angular;
+  predictor.predict(1350 * MS, linear, angular);
+  EXPECT_DOUBLE_EQ(linear, 1.2);
+}
+
+TEST(CommandPredictor, HoldsPastTheHorizon)
+{
+  CommandPredictor predictor;
+  // commands at most 250 ms apart, extrapolated by at most 100 ms
+  predictor.configure(1, 0.25, 0.1);
+  predictor.add(1000 * MS, 1.0, 0.0);
+  predictor.add(1200 * MS, 1.2, 0.0);
+  double linear, angular;
+  predictor.predict(1300 * MS, linear, angular);
+  EXPECT_NEAR(linear, 1.3, 1e-9);
+  predictor.predict(1301 * MS, linear, angular);
+  EXPECT_DOUBLE_EQ(linear, 1.2);
+}
+
+TEST(CommandPredictor, NeverChangesTheSign)
+{
+  CommandPredictor predictor;
+  predictor.configure(1, 0.25, 0.5);
+  predictor.add(1000 * MS, 0.2, -0.2);
+  predictor.add(1100 * MS, 0.1, -0.1);
+  double linear, angular;
+  predictor.predict(1300 * MS, linear, angular);
+  EXPECT_DOUBLE_EQ(linear, 0.0);
+  EXPECT_DOUBLE_EQ(angular, 0.0);
+}
+
+TEST(CommandPredictor, IgnoresOlderCommands)
+{
+  CommandPredictor predictor;
+  predictor.configure(1, 0.25, 0.5);
+  predictor.add(1000 * MS, 1.0, 0.0);
+  predictor.add(1100 * MS, 1.2, 0.0);
+  predictor.add(1050 * MS, 5.0, 0.0);
+  predictor.add(1100 * MS, 5.0, 0.0);
+  double linear, angular;
+  predictor.predict(1100 * MS, linear, angular);
+  EXPECT_NEAR(linear, 1.2, 1e-9);
+
+  predictor.reset();
+  predictor.predict(1100 * MS, linear, angular);
+  EXPECT_DOUBLE_EQ(linear, 0.0);
+}
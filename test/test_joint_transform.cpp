@@ -0,0 +1,112 @@
+// Copyright 2021 Faiz Pangestu
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Maintainer : Faiz Pangestu
+ */
+
+#include <gtest/gtest.h>
+
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "ack_6wd_controller/joint_transform.hpp"
+
+using ack_6wd_controller::JointTransform;
+using ack_6wd_controller::JointTransformTable;
+
+namespace
+{
+JointTransform make_transform(double scale, double sign, double offset)
+{
+  JointTransform transform;
+  transform.scale = scale;
+  transform.sign = sign;
+  transform.offset = offset;
+  return transform;
+}
+}  // namespace
+
+TEST(JointTransformTable, InvertUndoesApply)
+{
+  JointTransformTable table;
+  std::string error;
+  ASSERT_TRUE(table.configure(
+    {make_transform(1.0, 1.0, 0.0), make_transform(2.5, -1.0, 0.3),
+     make_transform(9.549, 1.0, -1.0)},
+    error));
+  ASSERT_EQ(table.size(), 3u);
+
+  const double values[] = {0.7, -1.2, 3.4};
+  double hardware[3];
+  table.apply(values, hardware);
+  EXPECT_DOUBLE_EQ(hardware[0], 0.7);
+  EXPECT_DOUBLE_EQ(hardware[1], -2.5 * -1.2 + 0.3);
+  EXPECT_DOUBLE_EQ(hardware[2], 9.549 * 3.4 - 1.0);
+
+  double controller[3];
+  table.invert(hardware, controller);
+  for (size_t index = 0; index < 3; ++index)
+  {
+    EXPECT_NEAR(controller[index], values[index], 1e-12);
+  }
+}
+
+TEST(JointTransformTable, InvertLeavesOutTheClamp)
+{
+  JointTransform transform = make_transform(2.0, 1.0, 1.0);
+  transform.lower_limit = -1.0;
+  transform.upper_limit = 1.0;
+  JointTransformTable table;
+  std::string error;
+  ASSERT_TRUE(table.configure({transform}, error));
+
+  double value = 3.0;
+  table.apply(&value, &value);
+  EXPECT_DOUBLE_EQ(value, 1.0);
+
+  // a state outside the limits is read back as it is
+  value = 5.0;
+  table.invert(&value, &value);
+  EXPECT_DOUBLE_EQ(value, 2.0);
+}
+
+TEST(JointTransformTable, ReportsTheSign)
+{
+  JointTransformTable table;
+  std::string error;
+  ASSERT_TRUE(
+    table.configure({make_transform(3.0, 1.0, 0.0), make_transform(3.0, -1.0, 0.0)}, error));
+  EXPECT_DOUBLE_EQ(table.getSign(0), 1.0);
+  EXPECT_DOUBLE_EQ(table.getSign(1), -1.0);
+}
+
+TEST(JointTransformTable, RejectsInvalidTransforms)
+{
+  JointTransformTable table;
+  std::string error;
+  EXPECT_FALSE(table.configure({make_transform(0.0, 1.0, 0.0)}, error));
+  EXPECT_FALSE(error.empty());
+  EXPECT_FALSE(table.configure(
+    {make_transform(std::numeric_limits<double>::infinity(), 1.0, 0.0)}, error));
+  EXPECT_FALSE(table.configure({make_transform(1.0, 0.5, 0.0)}, error));
+  EXPECT_FALSE(table.configure(
+    {make_transform(1.0, 1.0, std::numeric_limits<double>::quiet_NaN())}, error));
+
+  JointTransform transform;
+  transform.lower_limit = 1.0;
+  transform.upper_limit = -1.0;
+  EXPECT_FALSE(table.configure({transform}, error));
+}
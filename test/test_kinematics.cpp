@@ -0,0 +1,118 @@
+// Copyright 2021 Faiz Pangestu
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Maintainer : Faiz Pangestu
+ */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <limits>
+
+#include "ack_6wd_controller/kinematics.hpp"
+
+using ack_6wd_controller::minimum_turning_radius;
+using ack_6wd_controller::project_feasible_command;
+using ack_6wd_controller::PRESERVE_CURVATURE;
+using ack_6wd_controller::PRESERVE_SPEED;
+
+TEST(MinimumTurningRadius, FollowsTheInverseKinematics)
+{
+  const double wheel_base = 1.0;
+  const double wheel_separation = 2.0;
+  EXPECT_NEAR(minimum_turning_radius(wheel_base, wheel_separation, M_PI / 4), 1.5, 1e-12);
+  // steering at a right angle turns about the middle of the base line
+  EXPECT_NEAR(minimum_turning_radius(wheel_base, wheel_separation, M_PI / 2), 0.5, 1e-12);
+
+  // the inner steered wheel is at the steering limit on that radius
+  const double max_angle = 0.5;
+  const double radius = minimum_turning_radius(wheel_base, wheel_separation, max_angle);
+  EXPECT_NEAR(std::atan(wheel_separation / (2 * radius - wheel_base)), max_angle, 1e-12);
+}
+
+TEST(ProjectFeasibleCommand, PassesFeasibleCommands)
+{
+  double linear = 1.0;
+  double angular = 0.5;
+  EXPECT_FALSE(project_feasible_command(2.0, PRESERVE_SPEED, linear, angular));
+  EXPECT_DOUBLE_EQ(linear, 1.0);
+  EXPECT_DOUBLE_EQ(angular, 0.5);
+
+  linear = -1.0;
+  angular = -0.5;
+  EXPECT_FALSE(project_feasible_command(2.0, PRESERVE_CURVATURE, linear, angular));
+  EXPECT_DOUBLE_EQ(linear, -1.0);
+  EXPECT_DOUBLE_EQ(angular, -0.5);
+}
+
+TEST(ProjectFeasibleCommand, PreservesTheSpeed)
+{
+  double linear = 1.0;
+  double angular = -2.0;
+  EXPECT_TRUE(project_feasible_command(2.0, PRESERVE_SPEED, linear, angular));
+  EXPECT_DOUBLE_EQ(linear, 1.0);
+  EXPECT_DOUBLE_EQ(angular, -0.5);
+
+  linear = -1.0;
+  angular = 2.0;
+  EXPECT_TRUE(project_feasible_command(2.0, PRESERVE_SPEED, linear, angular));
+  EXPECT_DOUBLE_EQ(linear, -1.0);
+  EXPECT_DOUBLE_EQ(angular, 0.5);
+}
+
+TEST(ProjectFeasibleCommand, PreservesTheCurvature)
+{
+  double linear = -1.0;
+  double angular = 2.0;
+  EXPECT_TRUE(project_feasible_command(2.0, PRESERVE_CURVATURE, linear, angular));
+  EXPECT_DOUBLE_EQ(linear, -4.0);
+  EXPECT_DOUBLE_EQ(angular, 2.0);
+}
+
+TEST(ProjectFeasibleCommand, MovesTurnsOnTheSpot)
+{
+  double linear = 0.0;
+  double angular = 1.0;
+  EXPECT_TRUE(project_feasible_command(2.0, PRESERVE_SPEED, linear, angular));
+  EXPECT_DOUBLE_EQ(linear, 0.0);
+  EXPECT_DOUBLE_EQ(angular, 0.0);
+
+  linear = 0.0;
+  angular = -1.0;
+  EXPECT_TRUE(project_feasible_command(2.0, PRESERVE_CURVATURE, linear, angular));
+  EXPECT_DOUBLE_EQ(linear, 2.0);
+  EXPECT_DOUBLE_EQ(angular, -1.0);
+}
+
+TEST(ProjectFeasibleCommand, PassesCommandsWithoutGeometry)
+{
+  const double radii[] = {0.0, -1.0, std::numeric_limits<double>::quiet_NaN()};
+  for (const double radius : radii)
+  {
+    double linear = 0.0;
+    double angular = 1.0;
+    EXPECT_FALSE(project_feasible_command(radius, PRESERVE_SPEED, linear, angular));
+    EXPECT_DOUBLE_EQ(linear, 0.0);
+    EXPECT_DOUBLE_EQ(angular, 1.0);
+  }
+
+  // what the controller computes with wheel_base and wheel_separation left at 0
+  double linear = 1.0;
+  double angular = 1.0;
+  EXPECT_FALSE(project_feasible_command(
+    minimum_turning_radius(0.0, 0.0, 0.5), PRESERVE_CURVATURE, linear, angular));
+  EXPECT_DOUBLE_EQ(linear, 1.0);
+  EXPECT_DOUBLE_EQ(angular, 1.0);
+}
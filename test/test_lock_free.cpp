@@ -0,0 +1,166 @@
+// Copyright 2021 Faiz Pangestu
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Maintainer : Faiz Pangestu
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "ack_6wd_controller/seqlock.hpp"
+#include "ack_6wd_controller/triple_buffer.hpp"
+
+using ack_6wd_controller::Seqlock;
+using ack_6wd_controller::TripleBuffer;
+
+namespace
+{
+// a torn copy breaks the relation of the fields
+struct Sample
+{
+  int64_t counter;
+  int64_t negated;
+  double scaled;
+};
+
+Sample make_sample(int64_t counter)
+{
+  return Sample{counter, -counter, 0.5 * static_cast<double>(counter)};
+}
+
+bool consistent(const Sample & sample)
+{
+  return sample.negated == -sample.counter &&
+         sample.scaled == 0.5 * static_cast<double>(sample.counter);
+}
+}  // namespace
+
+TEST(Seqlock, ReadsTheLatestWrite)
+{
+  Seqlock<Sample> seqlock(make_sample(1));
+  Sample sample{};
+  const uint32_t first = seqlock.read(sample);
+  EXPECT_EQ(sample.counter, 1);
+
+  seqlock.write(make_sample(2));
+  EXPECT_EQ(seqlock.sequence(), first + 2);
+  ASSERT_TRUE(seqlock.tryRead(sample));
+  EXPECT_EQ(sample.counter, 2);
+  EXPECT_TRUE(consistent(sample));
+}
+
+TEST(Seqlock, NeverReadsATornValue)
+{
+  Seqlock<Sample> seqlock(make_sample(0));
+  std::atomic<bool> done{false};
+  std::thread writer([&seqlock, &done]() {
+    for (int64_t counter = 1; counter <= 200000; ++counter)
+    {
+      seqlock.write(make_sample(counter));
+    }
+    done = true;
+  });
+
+  int64_t last = 0;
+  size_t reads = 0;
+  while (!done || reads == 0)
+  {
+    Sample sample = make_sample(-1);
+    if (seqlock.tryRead(sample))
+    {
+      ASSERT_TRUE(consistent(sample));
+      ASSERT_GE(sample.counter, last);
+      last = sample.counter;
+      ++reads;
+    }
+    else
+    {
+      // a failed attempt leaves the value alone
+      ASSERT_EQ(sample.counter, -1);
+    }
+  }
+  writer.join();
+
+  Sample sample{};
+  seqlock.read(sample);
+  EXPECT_EQ(sample.counter, 200000);
+}
+
+TEST(TripleBuffer, HandsOverTheLatestPublishedBuffer)
+{
+  TripleBuffer<std::vector<int>> buffer;
+  buffer.initialize([](std::vector<int> & value) {
+    value.clear();
+    value.reserve(4);
+  });
+  EXPECT_FALSE(buffer.update());
+  EXPECT_TRUE(buffer.readBuffer().empty());
+
+  buffer.writeBuffer().assign({1});
+  buffer.publish();
+  buffer.writeBuffer().assign({2, 2});
+  buffer.publish();
+
+  ASSERT_TRUE(buffer.update());
+  EXPECT_EQ(buffer.readBuffer(), std::vector<int>({2, 2}));
+  // nothing newer, the reader keeps its buffer
+  EXPECT_FALSE(buffer.update());
+  EXPECT_EQ(buffer.readBuffer(), std::vector<int>({2, 2}));
+
+  // the writer never gets the buffer held by the reader
+  buffer.writeBuffer().assign({3, 3, 3});
+  EXPECT_EQ(buffer.readBuffer(), std::vector<int>({2, 2}));
+  buffer.publish();
+  ASSERT_TRUE(buffer.update());
+  EXPECT_EQ(buffer.readBuffer(), std::vector<int>({3, 3, 3}));
+}
+
+TEST(TripleBuffer, NeverHandsOverABufferBeingWritten)
+{
+  TripleBuffer<Sample> buffer;
+  buffer.initialize([](Sample & value) { value = make_sample(0); });
+  std::atomic<bool> done{false};
+  std::thread writer([&buffer, &done]() {
+    for (int64_t counter = 1; counter <= 200000; ++counter)
+    {
+      Sample & sample = buffer.writeBuffer();
+      sample.counter = counter;
+      sample.negated = -counter;
+      sample.scaled = 0.5 * static_cast<double>(counter);
+      buffer.publish();
+    }
+    done = true;
+  });
+
+  int64_t last = 0;
+  while (!done)
+  {
+    if (buffer.update())
+    {
+      const Sample & sample = buffer.readBuffer();
+      ASSERT_TRUE(consistent(sample));
+      ASSERT_GT(sample.counter, last);
+      last = sample.counter;
+    }
+  }
+  writer.join();
+
+  buffer.update();
+  EXPECT_EQ(buffer.readBuffer().counter, 200000);
+}
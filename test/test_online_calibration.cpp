@@ -0,0 +1,115 @@
+// Copyright 2021 Faiz Pangestu
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Maintainer : Faiz Pangestu
+ */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include "ack_6wd_controller/online_calibration.hpp"
+
+using ack_6wd_controller::OnlineCalibration;
+using ack_6wd_controller::ScalarRecursiveLeastSquares;
+
+TEST(ScalarRecursiveLeastSquares, FitsTheGain)
+{
+  ScalarRecursiveLeastSquares fit(1.0);
+  fit.reset(1.0);
+  for (int i = 0; i < 100; ++i)
+  {
+    const double x = 0.2 + 0.01 * i;
+    fit.update(x, 1.05 * x);
+  }
+  EXPECT_NEAR(fit.getEstimate(), 1.05, 1e-4);
+  EXPECT_EQ(fit.getSampleCount(), 100u);
+
+  fit.reset(1.0);
+  EXPECT_DOUBLE_EQ(fit.getEstimate(), 1.0);
+  EXPECT_EQ(fit.getSampleCount(), 0u);
+}
+
+TEST(ScalarRecursiveLeastSquares, ForgetsOldSamples)
+{
+  ScalarRecursiveLeastSquares forgetting(0.95);
+  ScalarRecursiveLeastSquares remembering(1.0);
+  forgetting.reset(1.0);
+  remembering.reset(1.0);
+  for (int i = 0; i < 200; ++i)
+  {
+    forgetting.update(1.0, 1.0);
+    remembering.update(1.0, 1.0);
+  }
+  // the gain changes
+  for (int i = 0; i < 200; ++i)
+  {
+    forgetting.update(1.0, 2.0);
+    remembering.update(1.0, 2.0);
+  }
+  EXPECT_NEAR(forgetting.getEstimate(), 2.0, 1e-3);
+  EXPECT_NEAR(remembering.getEstimate(), 1.5, 1e-2);
+}
+
+TEST(OnlineCalibration, SuggestsTheWheelRadiusFromStraightDriving)
+{
+  OnlineCalibration calibration;
+  calibration.reset();
+  for (int i = 0; i < 300; ++i)
+  {
+    // the wheels are 2 % larger than configured
+    const double odometry = 0.5 + 0.001 * i;
+    calibration.update(odometry, 0.0, odometry, 0.0, 1.02 * odometry, 0.0, true);
+  }
+  const auto suggestion = calibration.suggest(0.1, 1.0, 1.0);
+  EXPECT_NEAR(suggestion.wheel_radius, 0.102, 1e-5);
+  // no turns, nothing learnt about them
+  EXPECT_DOUBLE_EQ(suggestion.steering_angle_correction, 1.0);
+  EXPECT_DOUBLE_EQ(suggestion.angular_velocity_compensation, 1.0);
+}
+
+TEST(OnlineCalibration, SuggestsTheSteeringCorrectionFromTurns)
+{
+  OnlineCalibration calibration;
+  calibration.reset();
+  for (int i = 0; i < 300; ++i)
+  {
+    // the base turns 10 % less than commanded, an IMU measures the yaw rate
+    const double angular = 0.2 + 0.001 * i;
+    calibration.update(0.5, angular, 0.5, angular, 0.0, 0.9 * angular, false);
+  }
+  const auto suggestion = calibration.suggest(0.1, 1.0, 1.0);
+  EXPECT_NEAR(suggestion.steering_angle_correction, 1.0 / 0.9, 1e-4);
+  // without a reference speed the speed fits stay untouched
+  EXPECT_DOUBLE_EQ(suggestion.wheel_radius, 0.1);
+  EXPECT_DOUBLE_EQ(suggestion.angular_velocity_compensation, 1.0);
+}
+
+TEST(OnlineCalibration, WaitsForEnoughSamples)
+{
+  OnlineCalibration calibration;
+  calibration.reset();
+  for (int i = 0; i < 50; ++i)
+  {
+    calibration.update(0.5, 0.0, 0.5, 0.0, 0.6, 0.0, true);
+  }
+  // standing still tells nothing
+  for (int i = 0; i < 500; ++i)
+  {
+    calibration.update(0.0, 0.0, 0.0, 0.0, 0.01, 0.0, true);
+  }
+  const auto suggestion = calibration.suggest(0.1, 1.0, 1.0);
+  EXPECT_DOUBLE_EQ(suggestion.wheel_radius, 0.1);
+}
@@ -0,0 +1,153 @@
+// Copyright 2021 Faiz Pangestu
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Maintainer : Faiz Pangestu
+ */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+#include "ack_6wd_controller/path_tracker.hpp"
+
+using ack_6wd_controller::PathPoint;
+using ack_6wd_controller::PurePursuit;
+using ack_6wd_controller::TrackedPath;
+
+namespace
+{
+constexpr size_t CAPACITY = 1000;
+
+// Points every step along the x axis, from 0 to length
+std::vector<PathPoint> straight(double length, double step)
+{
+  std::vector<PathPoint> points;
+  for (double x = 0.0; x <= length + 1e-9; x += step)
+  {
+    points.push_back({x, 0.0});
+  }
+  return points;
+}
+
+class PurePursuitTest : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    path_.points.reserve(CAPACITY);
+    path_.arc_lengths.reserve(CAPACITY);
+    tracker_.configure(PurePursuit::Params());
+  }
+
+  TrackedPath path_;
+  PurePursuit tracker_;
+  double linear_ = 0.0;
+  double angular_ = 0.0;
+};
+}  // namespace
+
+TEST_F(PurePursuitTest, MeasuresTheArcLength)
+{
+  ASSERT_TRUE(path_.assign({{0.0, 0.0}, {3.0, 4.0}, {3.0, 6.0}}));
+  ASSERT_EQ(path_.arc_lengths.size(), 3u);
+  EXPECT_DOUBLE_EQ(path_.arc_lengths[0], 0.0);
+  EXPECT_DOUBLE_EQ(path_.arc_lengths[1], 5.0);
+  EXPECT_DOUBLE_EQ(path_.arc_lengths[2], 7.0);
+
+  // never grows past the reserved capacity
+  EXPECT_FALSE(path_.assign(std::vector<PathPoint>(CAPACITY + 1, PathPoint{0.0, 0.0})));
+}
+
+TEST_F(PurePursuitTest, CommandsNothingWithoutAPath)
+{
+  EXPECT_EQ(tracker_.compute(0.0, 0.0, 0.0, 0.0, linear_, angular_), PurePursuit::NO_PATH);
+  EXPECT_DOUBLE_EQ(linear_, 0.0);
+  EXPECT_DOUBLE_EQ(angular_, 0.0);
+}
+
+TEST_F(PurePursuitTest, SteersBackOntoThePath)
+{
+  ASSERT_TRUE(path_.assign(straight(10.0, 0.1)));
+  tracker_.setPath(path_);
+
+  EXPECT_EQ(tracker_.compute(0.0, 0.0, 0.0, 0.5, linear_, angular_), PurePursuit::TRACKING);
+  EXPECT_DOUBLE_EQ(linear_, PurePursuit::Params().speed);
+  EXPECT_NEAR(angular_, 0.0, 1e-9);
+
+  // right of the path, turn left
+  EXPECT_EQ(tracker_.compute(1.0, -0.3, 0.0, 0.5, linear_, angular_), PurePursuit::TRACKING);
+  EXPECT_GT(angular_, 0.0);
+  // left of the path, turn right
+  EXPECT_EQ(tracker_.compute(1.0, 0.3, 0.0, 0.5, linear_, angular_), PurePursuit::TRACKING);
+  EXPECT_LT(angular_, 0.0);
+}
+
+TEST_F(PurePursuitTest, SlowsDownAndStopsAtTheGoal)
+{
+  ASSERT_TRUE(path_.assign(straight(2.0, 0.1)));
+  tracker_.setPath(path_);
+
+  // 0.12 m left, sqrt(2 * 0.5 * 0.12)
+  EXPECT_EQ(tracker_.compute(1.88, 0.0, 0.0, 0.5, linear_, angular_), PurePursuit::TRACKING);
+  EXPECT_NEAR(linear_, std::sqrt(0.12), 1e-6);
+
+  EXPECT_EQ(
+    tracker_.compute(1.95, 0.0, 0.0, 0.2, linear_, angular_), PurePursuit::GOAL_REACHED);
+  EXPECT_DOUBLE_EQ(linear_, 0.0);
+  EXPECT_DOUBLE_EQ(angular_, 0.0);
+  EXPECT_EQ(tracker_.compute(1.95, 0.0, 0.0, 0.0, linear_, angular_), PurePursuit::NO_PATH);
+}
+
+TEST_F(PurePursuitTest, FollowsAClosedPathToItsEnd)
+{
+  // square loop ending where it starts
+  std::vector<PathPoint> points;
+  const int per_side = 20;
+  for (int i = 0; i < per_side; ++i)
+  {
+    points.push_back({0.1 * i, 0.0});
+  }
+  for (int i = 0; i < per_side; ++i)
+  {
+    points.push_back({2.0, 0.1 * i});
+  }
+  for (int i = 0; i < per_side; ++i)
+  {
+    points.push_back({2.0 - 0.1 * i, 2.0});
+  }
+  for (int i = 0; i <= per_side; ++i)
+  {
+    points.push_back({0.0, 2.0 - 0.1 * i});
+  }
+  ASSERT_TRUE(path_.assign(points));
+  tracker_.setPath(path_);
+
+  // the start is as close to the goal, still the loop is driven first
+  EXPECT_EQ(tracker_.compute(0.0, 0.0, 0.0, 0.5, linear_, angular_), PurePursuit::TRACKING);
+  EXPECT_GT(linear_, 0.0);
+
+  // drive along the points up to the goal tolerance, the progress follows
+  for (size_t i = 1; i + 2 < points.size(); ++i)
+  {
+    ASSERT_EQ(
+      tracker_.compute(points[i].x, points[i].y, 0.0, 0.5, linear_, angular_),
+      PurePursuit::TRACKING)
+      << "at point " << i;
+  }
+  EXPECT_EQ(
+    tracker_.compute(points.back().x, points.back().y, 0.0, 0.5, linear_, angular_),
+    PurePursuit::GOAL_REACHED);
+}
@@ -0,0 +1,62 @@
+// Copyright 2021 Faiz Pangestu
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Maintainer : Faiz Pangestu
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+#include "ack_6wd_controller/tick_accumulator.hpp"
+
+using ack_6wd_controller::TickAccumulator;
+
+TEST(TickAccumulator, CountsFromTheFirstReading)
+{
+  TickAccumulator accumulator;
+  EXPECT_EQ(accumulator.accumulate(1000.0), 0);
+  EXPECT_EQ(accumulator.accumulate(1010.0), 10);
+  EXPECT_EQ(accumulator.accumulate(990.4), -10);
+  EXPECT_EQ(accumulator.getTicks(), -10);
+
+  accumulator.reset();
+  EXPECT_EQ(accumulator.accumulate(5.0), 0);
+}
+
+TEST(TickAccumulator, FollowsTheCounterAcrossWraps)
+{
+  TickAccumulator accumulator(65536);
+  accumulator.accumulate(65530.0);
+  EXPECT_EQ(accumulator.accumulate(5.0), 11);
+  EXPECT_EQ(accumulator.accumulate(65530.0), 0);
+  EXPECT_EQ(accumulator.accumulate(65000.0), -530);
+}
+
+TEST(TickAccumulator, StaysExactOverManyRevolutions)
+{
+  const int64_t wrap = 4096;
+  const int64_t step = 1500;
+  const int64_t steps = 1000000;
+  TickAccumulator accumulator(wrap);
+  accumulator.accumulate(0.0);
+  int64_t counter = 0;
+  for (int64_t i = 0; i < steps; ++i)
+  {
+    counter = (counter + step) % wrap;
+    accumulator.accumulate(static_cast<double>(counter));
+  }
+  EXPECT_EQ(accumulator.getTicks(), step * steps);
+}
@@ -0,0 +1,102 @@
+// Copyright 2021 Faiz Pangestu
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Maintainer : Faiz Pangestu
+ */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include "ack_6wd_controller/zone_map.hpp"
+
+using ack_6wd_controller::ZoneMap;
+
+namespace
+{
+class ZoneMapTest : public ::testing::Test
+{
+protected:
+  void TearDown() override { std::remove(path_.c_str()); }
+
+  // Writes a zone file, returns its path
+  const std::string & write(const std::string & contents)
+  {
+    std::ofstream(path_) << contents;
+    return path_;
+  }
+
+  const std::string path_ = ::testing::TempDir() + "ack_6wd_controller_zones.txt";
+  ZoneMap map_;
+  std::string error_;
+};
+}  // namespace
+
+TEST_F(ZoneMapTest, LimitsTheSpeedInsideZones)
+{
+  ASSERT_TRUE(map_.load(
+    write(
+      "# max_speed x y ...\n"
+      "0.5  0 0  4 0  4 4  0 4\n"
+      "\n"
+      "0.2  1 1  2 1  2 2  1 2  # overlaps the first\n"),
+    0.1, 0.0, error_))
+    << error_;
+  EXPECT_EQ(map_.getZoneCount(), 2u);
+  EXPECT_FLOAT_EQ(map_.getSpeedLimit(3.0, 3.0), 0.5f);
+  // the lowest limit wins
+  EXPECT_FLOAT_EQ(map_.getSpeedLimit(1.5, 1.5), 0.2f);
+  EXPECT_TRUE(std::isinf(map_.getSpeedLimit(5.0, 5.0)));
+  EXPECT_TRUE(std::isinf(map_.getSpeedLimit(-100.0, 100.0)));
+}
+
+TEST_F(ZoneMapTest, GrowsZonesByTheMargin)
+{
+  ASSERT_TRUE(map_.load(write("0.3  0 0  2 0  2 2  0 2\n"), 0.1, 0.5, error_)) << error_;
+  EXPECT_FLOAT_EQ(map_.getSpeedLimit(2.3, 1.0), 0.3f);
+  EXPECT_FLOAT_EQ(map_.getSpeedLimit(-0.3, -0.3), 0.3f);
+  EXPECT_TRUE(std::isinf(map_.getSpeedLimit(3.0, 1.0)));
+}
+
+TEST_F(ZoneMapTest, KeepsZonesThinnerThanACell)
+{
+  ASSERT_TRUE(map_.load(write("0.1  10 10  10.02 10  10.02 10.02\n"), 0.1, 0.0, error_))
+    << error_;
+  EXPECT_FLOAT_EQ(map_.getSpeedLimit(10.01, 10.005), 0.1f);
+}
+
+TEST_F(ZoneMapTest, RejectsMalformedZones)
+{
+  // a vertex without its y
+  EXPECT_FALSE(map_.load(write("0.3  0 0  2 0  2 2  0\n"), 0.1, 0.0, error_));
+  EXPECT_NE(error_.find("line 1"), std::string::npos) << error_;
+  EXPECT_EQ(map_.getZoneCount(), 0u);
+
+  EXPECT_FALSE(map_.load(write("\n0.3  0 0  2 0\n"), 0.1, 0.0, error_));
+  EXPECT_NE(error_.find("line 2"), std::string::npos) << error_;
+  EXPECT_FALSE(map_.load(write("-0.3  0 0  2 0  2 2\n"), 0.1, 0.0, error_));
+  EXPECT_FALSE(map_.load(write("0.3  0 0  2 0  2 two\n"), 0.1, 0.0, error_));
+}
+
+TEST_F(ZoneMapTest, RejectsInvalidGrids)
+{
+  const std::string & path = write("0.3  0 0  2 0  2 2\n");
+  EXPECT_FALSE(map_.load(path, 0.0, 0.0, error_));
+  EXPECT_FALSE(map_.load(path, 0.1, -1.0, error_));
+  EXPECT_FALSE(map_.load(path_ + ".missing", 0.1, 0.0, error_));
+}